@@ -4,10 +4,32 @@
  * Purpose: Enumerate all unique polyomino shapes of size N using iterative algorithms
  * Features:
  *   - Loop-based BFS growth algorithm (non-recursive)
+ *   - Orderly generation by canonical augmentation (each shape produced once)
+ *   - Multithreaded level expansion on a work-stealing pool
+ *   - Checkpoint/resume of long BFS runs
  *   - Real-time progress tracking with time measurement
+ *   - Optional per-phase hardware counters (perf_event_open on Linux)
  *   - Canonical form deduplication using rotations/reflections
+ *   - AVX2 canonicalization kernel (all 8 symmetries at once, runtime dispatch)
+ *   - Sharded open-addressing set of compact 128-bit shape keys
+ *   - Arena-backed level storage (one contiguous block per level)
+ *   - Memory budget with spill to sorted runs and an external k-way merge
+ *   - Row-bitmask shape representation (inline, allocation-free copies)
  *   - Multiple enumeration types: free, one-sided, fixed
- *   - ASCII visualization and file export options
+ *   - Redelmeier counting engine (fixed counts, O(N) memory, no shape storage)
+ *   - Free/one-sided counts from fixed counts plus symmetric shapes (Burnside)
+ *   - Work-unit splitting of Redelmeier counts across processes (--unit, --merge)
+ *   - Transfer-matrix counting engine (fixed counts, free/one-sided via Burnside)
+ *   - ASCII visualization, text export and a memory-mapped binary format
+ *   - Compressed shape streams (delta + varint blocks with a block index)
+ *   - Shape ids: rank/unrank over a sorted shape file via a minimal perfect hash
+ *   - Streaming output through a background writer and a lock-free queue
+ *   - Header library (polyomino.hpp) with a streaming visitor API
+ *   - Shape statistics by perimeter, bounding box and holes (--stats)
+ *   - Symmetry classes of every size, giving all three series from one run
+ *   - Hole detection by word-parallel flood fill; hole-free enumeration
+ *   - Polycube (3D) enumeration with 24/48-element canonicalization (--dimension=3)
+ *   - Built-in benchmark suite (--bench) with JSON-lines results
  *   - Modular design with proper error handling
  * 
  * Validation:
@@ -15,410 +37,419 @@
  *   - Free pentominoes (N=5): 12 shapes  
  *   - Free hexominoes (N=6): 35 shapes
  * 
- * Compile: g++ -std=c++17 -O3 -Wall -Wextra -o polyomino polyomino.cpp
- * Usage: ./polyomino [N] [type] [options]
+ * Compile: g++ -std=c++17 -O3 -Wall -Wextra -pthread -o polyomino polyomino.cpp
+ * Usage: ./polyomino [N] [type] [options] [--engine=bfs|orderly|redelmeier|transfer]
  */
 
-#include <iostream>
-#include <vector>
-#include <set>
-#include <unordered_set>
-#include <queue>
-#include <chrono>
-#include <iomanip>
-#include <fstream>
-#include <algorithm>
-#include <string>
-#include <sstream>
+#include "polyomino.hpp"
 
-// Configuration structure
-struct Config {
-    int N = 16;                          // Size of polyominoes
-    std::string type = "free";          // free, one-sided, fixed
-    std::string output = "console";     // console, file, both
-    bool show_progress = true;          // Display progress updates
-    int progress_interval = 1000;      // Progress update frequency (ms)
-    bool show_shapes = false;           // Display ASCII shapes
-    std::string output_file = "polyominoes.txt";
-};
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
 
-// Point structure for coordinates
-struct Point {
-    int x, y;
-    
-    Point(int x = 0, int y = 0) : x(x), y(y) {}
-    
-    bool operator<(const Point& other) const {
-        return x < other.x || (x == other.x && y < other.y);
-    }
-    
-    bool operator==(const Point& other) const {
-        return x == other.x && y == other.y;
-    }
-    
-    Point operator+(const Point& other) const {
-        return Point(x + other.x, y + other.y);
-    }
-};
+using namespace polyomino;
 
-// Polyomino shape representation
-class Polyomino {
+// Benchmark suite - times the shape kernels and the end-to-end engines for
+// every size up to N and every enumeration type. Each measurement is one JSON
+// object per line on stdout, so runs can be diffed and plotted directly.
+class Benchmark {
 private:
-    std::vector<Point> cells;
+    Config config;
+    size_t mismatches = 0;              // Kernel cross-check failures
     
-public:
-    Polyomino() = default;
+    // Keeps the timed results observable so the loops are not optimized away
+    static volatile uint64_t sink;
     
-    explicit Polyomino(const std::vector<Point>& points) : cells(points) {
-        normalize();
-    }
+    struct Timing {
+        uint64_t ops = 0;                // Operations over all repetitions
+        double seconds = 0;
+        int reps = 0;
+    };
     
-    // Add a cell to the polyomino
-    void addCell(const Point& p) {
-        cells.push_back(p);
-        normalize();
+    // Repeat body() until at least min_seconds have passed; body returns the
+    // number of operations it performed
+    template <typename Body>
+    static Timing measure(Body body, double min_seconds = 0.05) {
+        Timing timing;
+        auto start = std::chrono::steady_clock::now();
+        do {
+            timing.ops += body();
+            ++timing.reps;
+            timing.seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+        } while (timing.seconds < min_seconds);
+        return timing;
     }
     
-    // Get all cells
-    const std::vector<Point>& getCells() const { return cells; }
-    
-    // Get size
-    size_t size() const { return cells.size(); }
-    
-    // Normalize: translate to origin and sort
-    void normalize() {
-        if (cells.empty()) return;
-        
-        // Find minimum coordinates
-        int min_x = cells[0].x, min_y = cells[0].y;
-        for (const auto& cell : cells) {
-            min_x = std::min(min_x, cell.x);
-            min_y = std::min(min_y, cell.y);
-        }
-        
-        // Translate to origin
-        for (auto& cell : cells) {
-            cell.x -= min_x;
-            cell.y -= min_y;
-        }
-        
-        // Sort for consistent representation
-        std::sort(cells.begin(), cells.end());
+    // Peak resident set size of the process in kilobytes (0 if unknown)
+    static long peakRssKb() {
+#if defined(__unix__) || defined(__APPLE__)
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+        return usage.ru_maxrss / 1024;
+#else
+        return usage.ru_maxrss;
+#endif
+#else
+        return 0;
+#endif
     }
     
-    // Generate rotated version (90 degrees clockwise)
-    Polyomino rotate() const {
-        std::vector<Point> rotated;
-        for (const auto& p : cells) {
-            rotated.emplace_back(p.y, -p.x);
-        }
-        return Polyomino(rotated);
+    // One result line; `extra` holds additional preformatted fields
+    void report(const std::string& kernel, int n, const std::string& type,
+                const Timing& timing, const std::string& extra = "") const {
+        double ns_per_op = timing.ops ? timing.seconds * 1e9 / timing.ops : 0;
+        std::ostringstream line;
+        line << std::fixed << std::setprecision(3)
+             << "{\"kernel\":\"" << kernel << "\""
+             << ",\"n\":" << n
+             << ",\"type\":\"" << type << "\""
+             << ",\"threads\":" << config.threads
+             << ",\"reps\":" << timing.reps
+             << ",\"ops\":" << timing.ops
+             << ",\"seconds\":" << std::setprecision(6) << timing.seconds
+             << ",\"ns_per_op\":" << std::setprecision(3) << ns_per_op
+             << extra
+             << ",\"peak_rss_kb\":" << peakRssKb() << "}";
+        std::cout << line.str() << std::endl;
     }
     
-    // Generate reflected version (horizontal flip)
-    Polyomino reflect() const {
-        std::vector<Point> reflected;
-        for (const auto& p : cells) {
-            reflected.emplace_back(-p.x, p.y);
-        }
-        return Polyomino(reflected);
-    }
-    
-    // Get hash for deduplication
-    size_t getHash() const {
-        size_t hash = 0;
-        for (const auto& p : cells) {
-            hash ^= std::hash<int>()(p.x) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
-            hash ^= std::hash<int>()(p.y) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    void runType(const std::string& type) {
+        Config cfg = config;
+        cfg.type = type;
+        cfg.show_progress = false;
+        cfg.show_summary = false;
+        ShapeNormalizer normalizer(type);
+        
+        std::vector<Polyomino> previous = {Polyomino(std::vector<Point>{{0, 0}})};
+        for (int n = 2; n <= config.N; ++n) {
+            // End-to-end enumeration with both shape-producing engines
+            std::vector<Polyomino> level;
+            for (const std::string engine : {"bfs", "orderly"}) {
+                cfg.N = n;
+                cfg.engine = engine;
+                ShapeGenerator generator(cfg);
+                size_t generated = 0;
+                Timing timing = measure([&]() {
+                    level = engine == "bfs" ? generator.enumerate() : generator.enumerateOrderly();
+                    generated = generator.getGeneratedCount();
+                    return static_cast<uint64_t>(level.size());
+                });
+                std::ostringstream extra;
+                extra << std::fixed << std::setprecision(3)
+                      << ",\"shapes\":" << level.size()
+                      << ",\"shapes_per_sec\":" << timing.ops / timing.seconds
+                      << ",\"ns_per_extension\":"
+                      << timing.seconds * 1e9 / (static_cast<double>(generated) * timing.reps);
+                report("enumerate_" + engine, n, type, timing, extra.str());
+            }
+            
+            // Growth and canonicalization of the previous level
+            ShapeGenerator generator(cfg);
+            std::vector<Polyomino> extensions;
+            Timing timing = measure([&]() {
+                extensions.clear();
+                for (const auto& shape : previous) generator.getExtensions(shape, extensions);
+                return static_cast<uint64_t>(extensions.size());
+            });
+            report("getExtensions", n, type, timing);
+            
+            timing = measure([&]() {
+                uint64_t acc = 0;
+                for (const auto& shape : extensions) acc += normalizer.getCanonical(shape).getHash();
+                sink = sink + acc;
+                return static_cast<uint64_t>(extensions.size());
+            });
+            report("getCanonical", n, type, timing);
+            
+            timing = measure([&]() {
+                uint64_t acc = 0;
+                for (const auto& shape : extensions) acc += normalizer.canonicalizeScalar(shape).shape.getHash();
+                sink = sink + acc;
+                return static_cast<uint64_t>(extensions.size());
+            });
+            report("canonicalize_scalar", n, type, timing);
+            
+#ifdef POLYOMINO_SIMD_CANONICAL
+            // The vector kernel must match the scalar one bit for bit
+            if (ShapeNormalizer::simdAvailable()) {
+                timing = measure([&]() {
+                    uint64_t acc = 0;
+                    for (const auto& shape : extensions) acc += normalizer.canonicalizeSimd(shape).shape.getHash();
+                    sink = sink + acc;
+                    return static_cast<uint64_t>(extensions.size());
+                });
+                report("canonicalize_simd", n, type, timing);
+                
+                for (const auto& shape : extensions) {
+                    CanonicalForm scalar = normalizer.canonicalizeScalar(shape);
+                    CanonicalForm simd = normalizer.canonicalizeSimd(shape);
+                    if (!(scalar.shape == simd.shape) || scalar.tied != simd.tied ||
+                        scalar.shape.getWidth() != simd.shape.getWidth() ||
+                        scalar.shape.getHeight() != simd.shape.getHeight()) {
+                        std::cerr << "Error: SIMD canonical form differs from the scalar one for\n"
+                                  << shape.toString() << "\n";
+                        mismatches++;
+                    }
+                }
+            }
+#endif
+            
+            // Shape kernels over the finished level
+            timing = measure([&]() {
+                uint64_t acc = 0;
+                for (const auto& shape : level) {
+                    Polyomino copy = shape;
+                    copy.normalize();
+                    acc += copy.getRow(0);
+                }
+                sink = sink + acc;
+                return static_cast<uint64_t>(level.size());
+            });
+            report("normalize", n, type, timing);
+            
+            timing = measure([&]() {
+                uint64_t acc = 0;
+                for (const auto& shape : level) acc += shape.rotate().getRow(0);
+                sink = sink + acc;
+                return static_cast<uint64_t>(level.size());
+            });
+            report("rotate", n, type, timing);
+            
+            timing = measure([&]() {
+                uint64_t acc = 0;
+                for (const auto& shape : level) acc += shape.reflect().getRow(0);
+                sink = sink + acc;
+                return static_cast<uint64_t>(level.size());
+            });
+            report("reflect", n, type, timing);
+            
+            timing = measure([&]() {
+                uint64_t acc = 0;
+                for (const auto& shape : level) acc += shape.hasHoles();
+                sink = sink + acc;
+                return static_cast<uint64_t>(level.size());
+            });
+            report("has_holes", n, type, timing);
+            
+            timing = measure([&]() {
+                uint64_t acc = 0;
+                for (const auto& shape : level) acc += static_cast<uint64_t>(shape.countHoles());
+                sink = sink + acc;
+                return static_cast<uint64_t>(level.size());
+            });
+            report("count_holes", n, type, timing);
+            
+            previous = std::move(level);
         }
-        return hash;
     }
     
-    // Equality comparison
-    bool operator==(const Polyomino& other) const {
-        return cells == other.cells;
-    }
+public:
+    // Size when --bench is given without N; the bfs and orderly records hold
+    // whole levels, so fixed 16-ominoes alone would take over 12 GB
+    static constexpr int DEFAULT_N = 10;
     
-    // Less than comparison for sets
-    bool operator<(const Polyomino& other) const {
-        return cells < other.cells;
-    }
+    explicit Benchmark(const Config& cfg) : config(cfg) {}
     
-    // Convert to string for output
-    std::string toString() const {
-        if (cells.empty()) return "";
-        
-        // Find bounding box
-        int max_x = 0, max_y = 0;
-        for (const auto& p : cells) {
-            max_x = std::max(max_x, p.x);
-            max_y = std::max(max_y, p.y);
+    // Run every benchmark; false if a kernel cross-check failed
+    bool run() {
+        for (const std::string type : {"free", "one-sided", "fixed"}) {
+            runType(type);
         }
-        
-        // Create grid
-        std::vector<std::string> grid(max_y + 1, std::string(max_x + 1, ' '));
-        for (const auto& p : cells) {
-            grid[p.y][p.x] = '#';
-        }
-        
-        // Convert to string
-        std::string result;
-        for (const auto& row : grid) {
-            result += row + "\n";
-        }
-        return result;
+        return mismatches == 0;
     }
 };
 
-// Hash function for unordered_set
-struct PolyominoHash {
-    size_t operator()(const Polyomino& p) const {
-        return p.getHash();
-    }
-};
-
-// Shape canonicalizer - handles symmetries
-class ShapeNormalizer {
-private:
-    std::string enumeration_type;
-    
-public:
-    explicit ShapeNormalizer(const std::string& type) : enumeration_type(type) {}
-    
-    // Get canonical form considering symmetries
-    Polyomino getCanonical(const Polyomino& shape) const {
-        std::vector<Polyomino> variants;
-        
-        // Generate all rotations
-        Polyomino current = shape;
-        for (int i = 0; i < 4; ++i) {
-            variants.push_back(current);
-            current = current.rotate();
-        }
-        
-        // For free and one-sided polyominoes, add reflections
-        if (enumeration_type == "free" || enumeration_type == "one-sided") {
-            Polyomino reflected = shape.reflect();
-            current = reflected;
-            for (int i = 0; i < 4; ++i) {
-                variants.push_back(current);
-                current = current.rotate();
-            }
-        }
-        
-        // Return lexicographically smallest variant
-        return *std::min_element(variants.begin(), variants.end());
-    }
-};
+volatile uint64_t Benchmark::sink = 0;
 
-// Progress tracker
-class ProgressTracker {
+// Output manager
+class OutputManager {
 private:
-    std::chrono::high_resolution_clock::time_point start_time;
-    std::chrono::high_resolution_clock::time_point last_update;
-    int update_interval_ms;
-    bool enabled;
+    Config config;
     
 public:
-    ProgressTracker(bool enabled = true, int interval_ms = 1000) 
-        : update_interval_ms(interval_ms), enabled(enabled) {
-        start_time = std::chrono::high_resolution_clock::now();
-        last_update = start_time;
-    }
+    explicit OutputManager(const Config& cfg) : config(cfg) {}
     
-    void update(int current_size, size_t unique_count, size_t total_generated) {
-        if (!enabled) return;
-        
-        auto now = std::chrono::high_resolution_clock::now();
-        auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_update).count();
+    void displayResults(const std::vector<Polyomino>& shapes) {
+        displaySummary(shapes.size());
         
-        if (elapsed_ms >= update_interval_ms) {
-            auto total_elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - start_time).count();
-            
-            std::cout << "\r[Size " << current_size << "] "
-                      << "Unique: " << unique_count << " | "
-                      << "Generated: " << total_generated << " | "
-                      << "Time: " << (total_elapsed_ms / 1000.0) << "s"
-                      << std::flush;
-            
-            last_update = now;
+        if (config.show_shapes && shapes.size() <= 50) {
+            std::cout << "Shape visualizations:\n";
+            for (size_t i = 0; i < shapes.size(); ++i) {
+                std::cout << "Shape " << (i + 1) << ":\n";
+                std::cout << shapes[i].toString() << "\n";
+            }
         }
     }
     
-    void finish(size_t final_count) {
-        auto end_time = std::chrono::high_resolution_clock::now();
-        auto total_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+    // Result header for a run whose shapes were streamed, not kept
+    void displaySummary(size_t count) {
+        std::cout << "\n=== Results ===\n";
+        std::cout << "Enumeration type: " << config.type << "\n";
+        std::cout << "Polyomino size: " << config.N << "\n";
+        std::cout << "Total unique shapes: " << count << "\n\n";
         
-        if (enabled) {
-            std::cout << "\r" << std::string(80, ' ') << "\r"; // Clear progress line
+        if (count > 50) {
+            std::cout << "Too many shapes to display. Use file output for complete list.\n";
         }
-        
-        std::cout << "✓ Enumeration completed in " << (total_time / 1000.0) << " seconds\n";
-        std::cout << "✓ Found " << final_count << " unique polyominoes\n";
     }
-};
-
-// Main shape generator using BFS-style growth
-class ShapeGenerator {
-private:
-    Config config;
-    ShapeNormalizer normalizer;
-    std::unordered_set<Polyomino, PolyominoHash> unique_shapes;
     
-    // Directions for adjacent cells (up, down, left, right)
-    const std::vector<Point> directions = {{0, 1}, {0, -1}, {1, 0}, {-1, 0}};
-    
-public:
-    explicit ShapeGenerator(const Config& cfg) 
-        : config(cfg), normalizer(cfg.type) {}
-    
-    // Check if a point is adjacent to any cell in the polyomino
-    bool isAdjacent(const Polyomino& poly, const Point& p) const {
-        for (const auto& cell : poly.getCells()) {
-            for (const auto& dir : directions) {
-                if (cell + dir == p) {
-                    return true;
-                }
-            }
-        }
-        return false;
+    void displayHoleCounts(uint64_t hole_free, uint64_t with_holes) {
+        std::cout << "\n=== Holes ===\n";
+        std::cout << "Hole-free: " << hole_free << "\n";
+        std::cout << "With holes: " << with_holes << "\n";
+        if (config.hole_free) std::cout << "(only hole-free shapes listed)\n";
+        std::cout << "\n";
     }
     
-    // Get all possible extensions of a polyomino
-    std::vector<Polyomino> getExtensions(const Polyomino& poly) const {
-        std::vector<Polyomino> extensions;
-        std::set<Point> candidates;
+    void displayCounts(const std::vector<uint64_t>& counts) {
+        std::cout << "\n=== Results ===\n";
+        std::cout << "Enumeration type: " << config.type << "\n";
+        std::cout << "Engine: " << config.engine << "\n";
+        std::cout << "Polyomino size: " << config.N << "\n\n";
         
-        // Find all adjacent empty cells
-        for (const auto& cell : poly.getCells()) {
-            for (const auto& dir : directions) {
-                Point candidate = cell + dir;
-                
-                // Check if candidate is not already in the polyomino
-                bool already_exists = false;
-                for (const auto& existing : poly.getCells()) {
-                    if (existing == candidate) {
-                        already_exists = true;
-                        break;
-                    }
-                }
-                
-                if (!already_exists) {
-                    candidates.insert(candidate);
-                }
-            }
+        std::cout << std::setw(4) << "N" << "  " << std::setw(20) << "Count" << "\n";
+        for (int n = 1; n <= config.N; ++n) {
+            std::cout << std::setw(4) << n << "  " << std::setw(20) << counts[n] << "\n";
         }
-        
-        // Create extensions
-        for (const auto& candidate : candidates) {
-            Polyomino extended = poly;
-            extended.addCell(candidate);
-            extensions.push_back(extended);
+        std::cout << "\n";
+    }
+    
+    // Burnside terms behind a free or one-sided count: the fixed count and
+    // the number of fixed shapes invariant under each symmetry class
+    void displayBurnsideTerms(const std::vector<uint64_t>& fixed, const SymmetryCounter::Terms& terms) {
+        std::cout << "\n=== Burnside Terms ===\n";
+        std::cout << std::setw(4) << "N" << "  " << std::setw(20) << "Fixed"
+                  << "  " << std::setw(10) << "Rot90" << "  " << std::setw(10) << "Rot180"
+                  << "  " << std::setw(10) << "Axis" << "  " << std::setw(10) << "Diagonal" << "\n";
+        for (int n = 1; n <= config.N; ++n) {
+            std::cout << std::setw(4) << n << "  " << std::setw(20) << fixed[n]
+                      << "  " << std::setw(10) << terms.rot90[n] << "  " << std::setw(10) << terms.rot180[n]
+                      << "  " << std::setw(10) << terms.mirror_axis[n]
+                      << "  " << std::setw(10) << terms.mirror_diag[n] << "\n";
         }
-        
-        return extensions;
     }
     
-    // Main enumeration function using iterative BFS
-    std::vector<Polyomino> enumerate() {
-        ProgressTracker tracker(config.show_progress);
-        unique_shapes.clear();
+    void saveToFile(const std::vector<Polyomino>& shapes) {
+        if (config.output == "console") return;
         
-        // Start with single cell polyomino
-        std::vector<std::set<Polyomino>> shapes_by_size(config.N + 1);
-        shapes_by_size[1].insert(Polyomino({{0, 0}}));
+        std::ofstream file(config.output_file);
+        if (!file.is_open()) {
+            std::cerr << "Error: Cannot open output file " << config.output_file << "\n";
+            return;
+        }
         
-        size_t total_generated = 0;
+        file << "Polyomino Enumeration Results\n";
+        file << "============================\n";
+        file << "Size: " << config.N << "\n";
+        file << "Type: " << config.type << "\n";
+        file << "Count: " << shapes.size() << "\n\n";
         
-        // Iteratively grow shapes
-        for (int size = 1; size < config.N; ++size) {
-            std::set<Polyomino> next_size_shapes;
-            
-            for (const auto& shape : shapes_by_size[size]) {
-                auto extensions = getExtensions(shape);
-                
-                for (const auto& ext : extensions) {
-                    total_generated++;
-                    
-                    // Get canonical form
-                    Polyomino canonical = normalizer.getCanonical(ext);
-                    next_size_shapes.insert(canonical);
-                    
-                    // Update progress
-                    if (total_generated % 100 == 0) {
-                        tracker.update(size + 1, next_size_shapes.size(), total_generated);
-                    }
-                }
-            }
-            
-            shapes_by_size[size + 1] = std::move(next_size_shapes);
+        for (size_t i = 0; i < shapes.size(); ++i) {
+            file << "Shape " << (i + 1) << ":\n";
+            file << shapes[i].toString() << "\n";
         }
         
-        // Convert final set to vector
-        std::vector<Polyomino> result(shapes_by_size[config.N].begin(), 
-                                    shapes_by_size[config.N].end());
-        
-        tracker.finish(result.size());
-        return result;
+        file.close();
+        std::cout << "Results saved to " << config.output_file << "\n";
     }
-};
-
-// Output manager
-class OutputManager {
-private:
-    Config config;
-    
-public:
-    explicit OutputManager(const Config& cfg) : config(cfg) {}
     
-    void displayResults(const std::vector<Polyomino>& shapes) {
+    // Polycubes are shown and saved with their layers side by side
+    void displayPolycubes(const LevelStore& cubes) {
         std::cout << "\n=== Results ===\n";
         std::cout << "Enumeration type: " << config.type << "\n";
-        std::cout << "Polyomino size: " << config.N << "\n";
-        std::cout << "Total unique shapes: " << shapes.size() << "\n\n";
+        std::cout << "Polycube size: " << config.N << "\n";
+        std::cout << "Total unique shapes: " << cubes.size() << "\n\n";
         
-        if (config.show_shapes && shapes.size() <= 50) {
-            std::cout << "Shape visualizations:\n";
-            for (size_t i = 0; i < shapes.size(); ++i) {
+        if (cubes.size() > 50) {
+            std::cout << "Too many shapes to display. Use file output for complete list.\n";
+        } else if (config.show_shapes) {
+            std::cout << "Shape visualizations (layers left to right):\n";
+            for (size_t i = 0; i < cubes.size(); ++i) {
                 std::cout << "Shape " << (i + 1) << ":\n";
-                std::cout << shapes[i].toString() << "\n";
+                std::cout << Polycube::fromKey(cubes[i]).toString() << "\n";
             }
-        } else if (shapes.size() > 50) {
-            std::cout << "Too many shapes to display. Use file output for complete list.\n";
         }
     }
     
-    void saveToFile(const std::vector<Polyomino>& shapes) {
-        if (config.output == "console") return;
-        
+    void savePolycubes(const LevelStore& cubes) {
         std::ofstream file(config.output_file);
         if (!file.is_open()) {
             std::cerr << "Error: Cannot open output file " << config.output_file << "\n";
             return;
         }
         
-        file << "Polyomino Enumeration Results\n";
+        file << "Polycube Enumeration Results\n";
         file << "============================\n";
         file << "Size: " << config.N << "\n";
         file << "Type: " << config.type << "\n";
-        file << "Count: " << shapes.size() << "\n\n";
+        file << "Count: " << cubes.size() << "\n\n";
         
-        for (size_t i = 0; i < shapes.size(); ++i) {
+        for (size_t i = 0; i < cubes.size(); ++i) {
             file << "Shape " << (i + 1) << ":\n";
-            file << shapes[i].toString() << "\n";
+            file << Polycube::fromKey(cubes[i]).toString() << "\n";
         }
         
         file.close();
         std::cout << "Results saved to " << config.output_file << "\n";
     }
+    
+    void saveBinary(const std::vector<Polyomino>& shapes) {
+        ShapeFileWriter writer;
+        if (!writer.open(config.binary_file, config.N, config.type)) {
+            std::cerr << "Error: Cannot open output file " << config.binary_file << "\n";
+            return;
+        }
+        
+        for (const auto& shape : shapes) {
+            writer.write(ShapeKey::fromShape(shape));
+        }
+        
+        if (!writer.close()) {
+            std::cerr << "Error: Failed writing " << config.binary_file << "\n";
+            return;
+        }
+        std::cout << "Results saved to " << config.binary_file << "\n";
+    }
+    
+    void saveCompressed(const std::vector<Polyomino>& shapes) {
+        CompressedShapeWriter writer;
+        if (!writer.open(config.compressed_file, config.N, config.type)) {
+            std::cerr << "Error: Cannot open output file " << config.compressed_file << "\n";
+            return;
+        }
+        
+        for (const auto& shape : shapes) {
+            writer.write(ShapeKey::fromShape(shape));
+        }
+        
+        if (!writer.close()) {
+            std::cerr << "Error: Failed writing " << config.compressed_file << "\n";
+            return;
+        }
+        std::cout << "Results saved to " << config.compressed_file << "\n";
+    }
 };
 
 // Input validation and parsing
 class InputValidator {
 public:
     static bool validateConfig(Config& config) {
-        if (config.N < 1 || config.N > 20) {
-            std::cerr << "Error: N must be between 1 and 20\n";
+        if (config.engine != "bfs" && config.engine != "orderly" && 
+            config.engine != "redelmeier" && config.engine != "transfer") {
+            std::cerr << "Error: Engine must be 'bfs', 'orderly', 'redelmeier' or 'transfer'\n";
+            return false;
+        }
+        
+        // Counting engines hold no shapes; their limits keep the run time
+        // reasonable (redelmeier) and every fixed count within 64 bits (transfer)
+        bool lists_shapes = config.engine == "bfs" || config.engine == "orderly";
+        int max_n = config.dimension == 3 ? Polycube::MAX_CELLS
+                  : lists_shapes ? 20 : config.engine == "redelmeier" ? 28 : 34;
+        if (config.N < 1 || config.N > max_n) {
+            std::cerr << "Error: N must be between 1 and " << max_n 
+                      << " for the " << config.engine << " engine\n";
             return false;
         }
         
@@ -427,28 +458,229 @@ public:
             return false;
         }
         
+        if (config.threads < 1) {
+            std::cerr << "Error: --threads must be positive (0 selects all cores)\n";
+            return false;
+        }
+        
+        if (config.dimension != 2 && config.dimension != 3) {
+            std::cerr << "Error: --dimension must be 2 (polyominoes) or 3 (polycubes)\n";
+            return false;
+        }
+        
+        // Polycubes run on a plain bfs engine with text output only
+        if (config.dimension == 3) {
+            bool plain = config.checkpoint_file.empty() && !config.resume && config.memory_limit == 0 &&
+                         !config.perf && !config.stats && !config.symmetry && !config.holes &&
+                         !config.hole_free && config.unit_count == 1;
+            if (config.engine != "bfs" || !plain) {
+                std::cerr << "Error: Polycubes support the plain bfs engine only\n";
+                return false;
+            }
+            if (config.output == "binary" || config.output == "compressed") {
+                std::cerr << "Error: Polycubes can be shown or saved as text only\n";
+                return false;
+            }
+        }
+        
+        if (config.threads > 1 && config.engine != "bfs") {
+            std::cerr << "Error: --threads is supported by the bfs engine only\n";
+            return false;
+        }
+        
+        if (config.memory_limit > 0 && config.engine != "bfs") {
+            std::cerr << "Error: --memory-limit is only supported by the bfs engine\n";
+            return false;
+        }
+        
+        if (config.memory_limit > 0 && !config.checkpoint_file.empty()) {
+            std::cerr << "Error: --memory-limit cannot be combined with --checkpoint\n";
+            return false;
+        }
+        
+        if (config.stats && config.engine != "bfs") {
+            std::cerr << "Error: Shape statistics are only collected by the bfs engine\n";
+            return false;
+        }
+        
+        if (config.stats && config.resume) {
+            std::cerr << "Error: --stats cannot be combined with --resume\n";
+            return false;
+        }
+        
+        if ((config.holes || config.hole_free) && config.engine != "bfs" && config.engine != "orderly") {
+            std::cerr << "Error: Hole checks need an engine that lists shapes (bfs or orderly)\n";
+            return false;
+        }
+        
+        if (config.symmetry && (config.engine != "bfs" || config.type == "fixed")) {
+            std::cerr << "Error: Symmetry classes need a free or one-sided bfs enumeration\n";
+            return false;
+        }
+        
+        if (config.symmetry && config.resume) {
+            std::cerr << "Error: --symmetry cannot be combined with --resume\n";
+            return false;
+        }
+        
+        if (config.perf && config.engine != "bfs") {
+            std::cerr << "Error: Phase counters are only recorded by the bfs engine\n";
+            return false;
+        }
+        
+        bool split = config.unit_count != 1 || config.unit_index != 0;
+        if (split && config.engine != "redelmeier") {
+            std::cerr << "Error: Work units are only supported by the redelmeier engine\n";
+            return false;
+        }
+        
+        if (config.unit_count < 1 || config.unit_index < 0 || config.unit_index >= config.unit_count) {
+            std::cerr << "Error: --unit=i/k needs k >= 1 and 0 <= i < k\n";
+            return false;
+        }
+        
+        if (config.prefix_depth < 0 || config.prefix_depth > config.N) {
+            std::cerr << "Error: Prefix depth must be between 1 and N (0: automatic)\n";
+            return false;
+        }
+        
+        if ((!config.checkpoint_file.empty() || config.resume) && config.engine != "bfs") {
+            std::cerr << "Error: Checkpoints are only supported by the bfs engine\n";
+            return false;
+        }
+        
+        if (config.resume && config.checkpoint_file.empty()) {
+            std::cerr << "Error: --resume needs --checkpoint=FILE\n";
+            return false;
+        }
+        
+        if (config.checkpoint_interval < 0) {
+            std::cerr << "Error: Checkpoint interval must be non-negative\n";
+            return false;
+        }
+        
+        if (split && config.type != "fixed") {
+            std::cerr << "Error: Work units count fixed polyominoes only\n";
+            return false;
+        }
+        
         return true;
     }
     
+    // Byte count with an optional K, M or G suffix (powers of 1024)
+    static uint64_t parseByteSize(const std::string& value) {
+        size_t used = 0;
+        uint64_t bytes = std::stoull(value, &used);
+        std::string suffix = value.substr(used);
+        if (suffix == "K" || suffix == "k") bytes <<= 10;
+        else if (suffix == "M" || suffix == "m") bytes <<= 20;
+        else if (suffix == "G" || suffix == "g") bytes <<= 30;
+        return bytes;
+    }
+    
     static Config parseArguments(int argc, char* argv[]) {
         Config config;
+        std::vector<std::string> positional;
+        
+        // Options take the form --name=value; everything else is positional
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg.rfind("--", 0) != 0) {
+                positional.push_back(arg);
+                continue;
+            }
+            
+            size_t eq = arg.find('=');
+            std::string name = arg.substr(2, eq == std::string::npos ? std::string::npos : eq - 2);
+            std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+            
+            if (name == "engine") {
+                config.engine = value;
+            } else if (name == "input") {
+                config.input_file = value;
+            } else if (name == "rank") {
+                config.rank_shape = value;
+            } else if (name == "unrank") {
+                config.unrank = true;
+                config.unrank_id = std::stoull(value);
+            } else if (name == "checkpoint") {
+                config.checkpoint_file = value;
+            } else if (name == "checkpoint-interval") {
+                config.checkpoint_interval = std::stoi(value);
+            } else if (name == "resume") {
+                config.resume = true;
+            } else if (name == "unit") {
+                size_t slash = value.find('/');
+                if (slash == std::string::npos) {
+                    std::cerr << "Error: --unit expects i/k\n";
+                    config.unit_count = 0;
+                } else {
+                    config.unit_index = std::stoi(value.substr(0, slash));
+                    config.unit_count = std::stoi(value.substr(slash + 1));
+                }
+            } else if (name == "prefix-depth") {
+                config.prefix_depth = std::stoi(value);
+            } else if (name == "merge") {
+                config.merge_files.push_back("");
+            } else if (name == "memory-limit") {
+                config.memory_limit = parseByteSize(value);
+            } else if (name == "spill-dir") {
+                config.spill_dir = value;
+            } else if (name == "perf") {
+                config.perf = true;
+                if (!value.empty()) config.perf_file = value;
+            } else if (name == "stats") {
+                config.stats = true;
+                if (!value.empty()) config.stats_file = value;
+            } else if (name == "dimension") {
+                config.dimension = std::stoi(value);
+            } else if (name == "holes") {
+                config.holes = true;
+            } else if (name == "hole-free") {
+                config.hole_free = true;
+            } else if (name == "symmetry") {
+                config.symmetry = true;
+            } else if (name == "bench") {
+                config.benchmark = true;
+            } else if (name == "threads") {
+                config.threads = std::stoi(value);
+                if (config.threads == 0) {
+                    config.threads = std::max(1u, std::thread::hardware_concurrency());
+                }
+            } else {
+                std::cerr << "Warning: Ignoring unknown option " << arg << "\n";
+            }
+        }
+        
+        // With --merge every positional argument is a unit file
+        if (!config.merge_files.empty()) {
+            config.merge_files = positional;
+            return config;
+        }
         
-        if (argc > 1) {
-            config.N = std::stoi(argv[1]);
+        if (positional.size() > 0) {
+            config.N = std::stoi(positional[0]);
+        } else if (config.benchmark) {
+            // The engine runs keep every level in memory; 16 would need >12 GB
+            config.N = Benchmark::DEFAULT_N;
         }
         
-        if (argc > 2) {
-            config.type = argv[2];
+        if (positional.size() > 1) {
+            config.type = positional[1];
         }
         
-        if (argc > 3) {
-            std::string arg3 = argv[3];
+        if (positional.size() > 2) {
+            std::string arg3 = positional[2];
             if (arg3 == "show") {
                 config.show_shapes = true;
             } else if (arg3 == "file") {
                 config.output = "file";
             } else if (arg3 == "both") {
                 config.output = "both";
+            } else if (arg3 == "binary") {
+                config.output = "binary";
+            } else if (arg3 == "compressed") {
+                config.output = "compressed";
             }
         }
         
@@ -457,8 +689,8 @@ public:
 };
 
 // Known values for validation
-void validateResults(int N, const std::string& type, size_t count) {
-    struct TestCase { int n; std::string t; size_t expected; };
+void validateResults(int N, const std::string& type, uint64_t count) {
+    struct TestCase { int n; std::string t; uint64_t expected; };
     std::vector<TestCase> known_values = {
         {1, "free", 1},
         {2, "free", 1},
@@ -470,24 +702,80 @@ void validateResults(int N, const std::string& type, size_t count) {
         {8, "free", 369},
         {9, "free", 1'285},
         {10, "free", 4'655},
-        {11, "free", 17'414},
+        {11, "free", 17'073},
         {12, "free", 63'600},
-        {13, "free", 235'276},
-        {14, "free", 878'570},
-        {15, "free", 3'287'604},
-        {16, "free", 12'408'500},
-        {17, "free", 47'160'284},
-        {18, "free", 179'862'604},
-        {19, "free", 688'626'106},
-        {20, "free", 2'646'244'748},
-        {21, "free", 10'185'113'832},
-        {22, "free", 39'253'596'008},
-        {23, "free", 151'681'137'845},
-        {24, "free", 586'318'555'560},
-        {25, "free", 2'271'460'081'634},
-        {26, "free", 8'818'899'287'013},
-        {27, "free", 34'292'650'679'456},
-        {28, "free", 133'943'708'915'991}
+        {13, "free", 238'591},
+        {14, "free", 901'971},
+        {15, "free", 3'426'576},
+        {16, "free", 13'079'255},
+        {17, "free", 50'107'909},
+        {18, "free", 192'622'052},
+        {19, "free", 742'624'232},
+        {20, "free", 2'870'671'950},
+        {21, "free", 11'123'060'678},
+        {22, "free", 43'191'857'688},
+        {23, "free", 168'047'007'728},
+        {24, "free", 654'999'700'403},
+        {25, "free", 2'557'227'044'764},
+        {26, "free", 9'999'088'822'075},
+        {27, "free", 39'153'010'938'487},
+        {28, "free", 153'511'100'594'603},
+        {1, "one-sided", 1},
+        {2, "one-sided", 1},
+        {3, "one-sided", 2},
+        {4, "one-sided", 7},
+        {5, "one-sided", 18},
+        {6, "one-sided", 60},
+        {7, "one-sided", 196},
+        {8, "one-sided", 704},
+        {9, "one-sided", 2'500},
+        {10, "one-sided", 9'189},
+        {11, "one-sided", 33'896},
+        {12, "one-sided", 126'759},
+        {13, "one-sided", 476'270},
+        {14, "one-sided", 1'802'312},
+        {15, "one-sided", 6'849'777},
+        {16, "one-sided", 26'152'418},
+        {17, "one-sided", 100'203'194},
+        {18, "one-sided", 385'221'143},
+        {19, "one-sided", 1'485'200'848},
+        {20, "one-sided", 5'741'256'764},
+        {21, "one-sided", 22'245'940'545},
+        {22, "one-sided", 86'383'382'827},
+        {23, "one-sided", 336'093'325'058},
+        {24, "one-sided", 1'309'998'125'640},
+        {25, "one-sided", 5'114'451'441'106},
+        {26, "one-sided", 19'998'172'734'786},
+        {27, "one-sided", 78'306'011'677'182},
+        {28, "one-sided", 307'022'182'222'506},
+        {1, "fixed", 1},
+        {2, "fixed", 2},
+        {3, "fixed", 6},
+        {4, "fixed", 19},
+        {5, "fixed", 63},
+        {6, "fixed", 216},
+        {7, "fixed", 760},
+        {8, "fixed", 2'725},
+        {9, "fixed", 9'910},
+        {10, "fixed", 36'446},
+        {11, "fixed", 135'268},
+        {12, "fixed", 505'861},
+        {13, "fixed", 1'903'890},
+        {14, "fixed", 7'204'874},
+        {15, "fixed", 27'394'666},
+        {16, "fixed", 104'592'937},
+        {17, "fixed", 400'795'844},
+        {18, "fixed", 1'540'820'542},
+        {19, "fixed", 5'940'738'676},
+        {20, "fixed", 22'964'779'660},
+        {21, "fixed", 88'983'512'783},
+        {22, "fixed", 345'532'572'678},
+        {23, "fixed", 1'344'372'335'524},
+        {24, "fixed", 5'239'988'770'268},
+        {25, "fixed", 20'457'802'016'011},
+        {26, "fixed", 79'992'676'367'108},
+        {27, "fixed", 313'224'032'098'244},
+        {28, "fixed", 1'228'088'671'826'973}
     };
     
     for (const auto& test : known_values) {
@@ -505,43 +793,428 @@ void validateResults(int N, const std::string& type, size_t count) {
     std::cout << "ℹ No validation data available for N=" << N << ", type=" << type << "\n";
 }
 
+// Known polycube counts (fixed: A001931, one-sided: A000162, free: A038119)
+void validatePolycubes(int N, const std::string& type, uint64_t count) {
+    struct TestCase { int n; std::string t; uint64_t expected; };
+    std::vector<TestCase> known_values = {
+        {1, "free", 1},
+        {2, "free", 1},
+        {3, "free", 2},
+        {4, "free", 7},
+        {5, "free", 23},
+        {6, "free", 112},
+        {7, "free", 607},
+        {8, "free", 3'811},
+        {9, "free", 25'413},
+        {10, "free", 178'083},
+        {11, "free", 1'279'537},
+        {12, "free", 9'371'094},
+        {1, "one-sided", 1},
+        {2, "one-sided", 1},
+        {3, "one-sided", 2},
+        {4, "one-sided", 8},
+        {5, "one-sided", 29},
+        {6, "one-sided", 166},
+        {7, "one-sided", 1'023},
+        {8, "one-sided", 6'922},
+        {9, "one-sided", 48'311},
+        {10, "one-sided", 346'543},
+        {11, "one-sided", 2'522'522},
+        {12, "one-sided", 18'598'427},
+        {1, "fixed", 1},
+        {2, "fixed", 3},
+        {3, "fixed", 15},
+        {4, "fixed", 86},
+        {5, "fixed", 534},
+        {6, "fixed", 3'481},
+        {7, "fixed", 23'502},
+        {8, "fixed", 162'913},
+        {9, "fixed", 1'152'870},
+        {10, "fixed", 8'294'738},
+        {11, "fixed", 60'494'549},
+        {12, "fixed", 446'205'905}
+    };
+    
+    for (const auto& test : known_values) {
+        if (test.n == N && test.t == type) {
+            if (count == test.expected) {
+                std::cout << "✓ Validation passed: matches known value\n";
+            } else {
+                std::cout << "✗ Validation failed: expected " << test.expected
+                         << ", got " << count << "\n";
+            }
+            return;
+        }
+    }
+    
+    std::cout << "ℹ No validation data available for N=" << N << ", type=" << type << " polycubes\n";
+}
+
+// Known hole-free counts (free: A000104)
+void validateHoleFree(int N, const std::string& type, uint64_t count) {
+    struct TestCase { int n; std::string t; uint64_t expected; };
+    std::vector<TestCase> known_values = {
+        {1, "free", 1},
+        {2, "free", 1},
+        {3, "free", 2},
+        {4, "free", 5},
+        {5, "free", 12},
+        {6, "free", 35},
+        {7, "free", 107},
+        {8, "free", 363},
+        {9, "free", 1'248},
+        {10, "free", 4'460},
+        {11, "free", 16'094},
+        {12, "free", 58'937},
+        {13, "free", 217'117},
+        {14, "free", 805'475}
+    };
+    
+    for (const auto& test : known_values) {
+        if (test.n == N && test.t == type) {
+            if (count == test.expected) {
+                std::cout << "✓ Validation passed: hole-free count matches known value\n";
+            } else {
+                std::cout << "✗ Validation failed: expected " << test.expected
+                         << " hole-free, got " << count << "\n";
+            }
+            return;
+        }
+    }
+    
+    std::cout << "ℹ No hole-free validation data available for N=" << N << ", type=" << type << "\n";
+}
+
 // Main function
 int main(int argc, char* argv[]) {
+    // Parse and validate configuration
+    Config config = InputValidator::parseArguments(argc, argv);
+    
+    // Benchmark output is JSON only, so it skips the banner
+    if (config.benchmark) {
+        if (!InputValidator::validateConfig(config)) return 1;
+        return Benchmark(config).run() ? 0 : 1;
+    }
+    
     std::cout << "Polyomino Enumerator v1.0\n";
     std::cout << "========================\n\n";
     
-    // Parse and validate configuration
-    Config config = InputValidator::parseArguments(argc, argv);
+    // Add up the unit files of a split run
+    if (!config.merge_files.empty()) {
+        WorkUnitFile merged;
+        std::string error;
+        if (!WorkUnitFile::merge(config.merge_files, merged, error)) {
+            std::cerr << "Error: " << error << "\n";
+            return 1;
+        }
+        
+        config.N = merged.n;
+        config.type = "fixed";
+        config.engine = "redelmeier";
+        std::cout << "Merged " << merged.total << " work units\n";
+        
+        OutputManager output_manager(config);
+        output_manager.displayCounts(merged.counts);
+        validateResults(config.N, config.type, merged.counts[config.N]);
+        return 0;
+    }
+    
+    // Look shapes up by id, or ids by shape, in a binary shape file
+    if (!config.rank_shape.empty() || config.unrank) {
+        if (config.input_file.empty()) {
+            std::cerr << "Error: --rank and --unrank need --input=FILE\n";
+            return 1;
+        }
+        
+        ShapeIndex index;
+        std::string error;
+        if (!index.open(config.input_file, error)) {
+            std::cerr << "Error: " << error << "\n";
+            return 1;
+        }
+        std::cout << "Loaded " << config.input_file << " (" << index.size() << " " << index.getType()
+                  << " shapes of size " << index.getN() << ")\n";
+        std::cout << (index.wasBuilt() ? "Built index " : "Index ") << index.getIndexPath()
+                  << " (" << index.bytes() << " bytes)\n\n";
+        
+        if (config.unrank) {
+            ShapeKey key;
+            if (!index.unrank(config.unrank_id, key)) {
+                std::cerr << "Error: Id " << config.unrank_id << " is out of range (0-"
+                          << index.size() - 1 << ")\n";
+                return 1;
+            }
+            std::cout << "Shape #" << config.unrank_id << ":\n" << key.toShape().toString();
+        }
+        
+        if (!config.rank_shape.empty()) {
+            Polyomino shape = Polyomino::parse(config.rank_shape);
+            if (static_cast<int>(shape.size()) != index.getN() || !shape.isConnected()) {
+                std::cerr << "Error: --rank expects a connected shape of " << index.getN()
+                          << " cells, rows separated by '/' (e.g. ##/#.)\n";
+                return 1;
+            }
+            ShapeKey key = ShapeKey::fromShape(ShapeNormalizer(index.getType()).getCanonical(shape));
+            uint64_t id = 0;
+            if (!index.rank(key, id)) {
+                std::cout << "Shape is not in " << config.input_file << "\n";
+                return 1;
+            }
+            std::cout << "Shape has id " << id << " (canonical form):\n" << key.toShape().toString();
+        }
+        return 0;
+    }
+    
+    // Read back a binary or compressed shape file instead of enumerating
+    if (!config.input_file.empty()) {
+        char magic[4] = {};
+        std::ifstream probe(config.input_file, std::ios::binary);
+        probe.read(magic, sizeof(magic));
+        probe.close();
+        
+        std::vector<ShapeKey> keys;
+        size_t count = 0;
+        std::string error;
+        if (std::memcmp(magic, "PLYZ", 4) == 0) {
+            CompressedShapeFile file;
+            LevelStore decoded;
+            if (!file.open(config.input_file, error)) {
+                std::cerr << "Error: " << error << "\n";
+                return 1;
+            }
+            if (!file.decodeAll(decoded, config.threads)) {
+                std::cerr << "Error: " << config.input_file << " has a corrupt block\n";
+                return 1;
+            }
+            config.N = file.getN();
+            config.type = file.getType();
+            count = file.size();
+            std::cout << "Loaded " << config.input_file << " (" << file.blockCount() << " blocks, "
+                      << file.fileBytes() << " bytes)\n";
+            if (count <= 50) keys.assign(decoded.begin(), decoded.end());
+        } else {
+            MappedShapeFile file;
+            if (!file.open(config.input_file, error)) {
+                std::cerr << "Error: " << error << "\n";
+                return 1;
+            }
+            config.N = file.getN();
+            config.type = file.getType();
+            count = file.size();
+            std::cout << "Loaded " << config.input_file << "\n";
+            if (count <= 50) keys.assign(file.begin(), file.end());
+        }
+        
+        std::vector<Polyomino> shapes;
+        for (const auto& key : keys) shapes.push_back(key.toShape());
+        
+        OutputManager output_manager(config);
+        if (config.show_shapes && count <= 50) {
+            output_manager.displayResults(shapes);
+        } else {
+            output_manager.displaySummary(count);
+        }
+        validateResults(config.N, config.type, count);
+        return 0;
+    }
     
     if (!InputValidator::validateConfig(config)) {
         std::cout << "Usage: " << argv[0] << " [N] [type] [options]\n";
-        std::cout << "  N: polyomino size (1-20, default: 5)\n";
+        std::cout << "  N: polyomino size (default: 16; up to 20 for bfs/orderly, 28 for redelmeier,\n";
+        std::cout << "     34 for transfer, 12 with --dimension=3)\n";
         std::cout << "  type: free|one-sided|fixed (default: free)\n";
-        std::cout << "  options: show|file|both (default: console only)\n";
+        std::cout << "  options: show|file|both|binary|compressed (default: console only)\n";
+        std::cout << "  --engine=bfs|orderly|redelmeier|transfer (default: bfs; redelmeier counts free/one-sided via Burnside)\n";
+        std::cout << "  --threads=K: worker threads for the bfs engine (0: all cores)\n";
+        std::cout << "  --input=FILE: read a binary or compressed shape file instead of enumerating\n";
+        std::cout << "  --rank=ROWS / --unrank=ID: shape id lookups in the --input file (rows like ##/#.)\n";
+        std::cout << "  --checkpoint=FILE: save bfs progress to FILE (--checkpoint-interval=SEC, default 600)\n";
+        std::cout << "  --resume: continue from the --checkpoint file\n";
+        std::cout << "  --unit=i/k: run work unit i of k (redelmeier; --prefix-depth=D sets the split size)\n";
+        std::cout << "  --merge FILES...: add up the unit files of a split run\n";
+        std::cout << "  --memory-limit=BYTES[K|M|G]: spill the bfs dedup set to sorted runs in --spill-dir=DIR\n";
+        std::cout << "  --perf[=FILE]: hardware counters per bfs phase and level (JSON to FILE)\n";
+        std::cout << "  --stats[=FILE]: histogram of every size by perimeter, box and holes (CSV to FILE)\n";
+        std::cout << "  --dimension=3: enumerate polycubes (bfs, N up to 12; free = rotations and reflections)\n";
+        std::cout << "  --holes: count shapes with and without holes; --hole-free lists only hole-free ones\n";
+        std::cout << "  --symmetry: count free/one-sided shapes by symmetry class (bfs) and derive the other series\n";
+        std::cout << "  --bench: time the shape kernels and engines for sizes 2..N (JSON lines; N defaults to 10)\n";
         return 1;
     }
     
     std::cout << "Configuration:\n";
     std::cout << "  Size (N): " << config.N << "\n";
     std::cout << "  Type: " << config.type << "\n";
-    std::cout << "  Output: " << config.output << "\n\n";
+    std::cout << "  Output: " << config.output << "\n";
+    std::cout << "  Engine: " << config.engine << "\n";
+    std::cout << "  Threads: " << config.threads << "\n";
+    if (config.dimension == 3) std::cout << "  Lattice: cubic (polycubes)\n";
+    if (config.unit_count > 1) {
+        std::cout << "  Work unit: " << config.unit_index << "/" << config.unit_count
+                  << " (prefix depth " << RedelmeierCounter::prefixDepth(config) << ")\n";
+    }
+    std::cout << "\n";
     
     // Generate polyominoes
     std::cout << "Starting enumeration...\n";
     
+    if (config.dimension == 3) {
+        PolycubeGenerator generator(config);
+        LevelStore cubes = generator.enumerate();
+        
+        OutputManager output_manager(config);
+        output_manager.displayPolycubes(cubes);
+        if (config.output == "file" || config.output == "both") output_manager.savePolycubes(cubes);
+        
+        validatePolycubes(config.N, config.type, cubes.size());
+        return 0;
+    }
+    
+    if (config.engine == "redelmeier" || config.engine == "transfer") {
+        OutputManager output_manager(config);
+        std::vector<uint64_t> counts;
+        if (config.engine == "redelmeier" && config.type != "fixed") {
+            BurnsideCounter burnside(config);
+            counts = burnside.count();
+            output_manager.displayBurnsideTerms(burnside.getFixed(), burnside.getTerms());
+        } else if (config.engine == "redelmeier") {
+            counts = RedelmeierCounter(config).count();
+        } else {
+            counts = TransferMatrixCounter(config).count();
+        }
+        
+        output_manager.displayCounts(counts);
+        
+        // A work unit only holds part of the counts; save it for --merge
+        if (config.unit_count > 1) {
+            WorkUnitFile unit;
+            unit.n = config.N;
+            unit.prefix = RedelmeierCounter::prefixDepth(config);
+            unit.index = config.unit_index;
+            unit.total = config.unit_count;
+            unit.counts = counts;
+            
+            std::string path = WorkUnitFile::defaultPath(unit.index, unit.total);
+            std::string error;
+            if (!unit.save(path, error)) {
+                std::cerr << "Error: " << error << "\n";
+                return 1;
+            }
+            std::cout << "Work unit " << unit.index << "/" << unit.total << " saved to " << path << "\n";
+            return 0;
+        }
+        
+        validateResults(config.N, config.type, counts[config.N]);
+        return 0;
+    }
+    
     ShapeGenerator generator(config);
-    auto shapes = generator.enumerate();
+    if (config.resume) {
+        std::string error;
+        if (!generator.resumeFrom(config.checkpoint_file, error)) {
+            std::cerr << "Error: " << error << "\n";
+            return 1;
+        }
+        std::cout << "Resuming from " << config.checkpoint_file << "\n";
+    }
+    
+    // Files from the bfs engine are written while the last level is merged;
+    // under a memory limit they always are, as the level is never held whole
+    std::unique_ptr<AsyncShapeWriter> writer;
+    if (config.engine == "bfs" && config.output != "console" &&
+        (!config.show_shapes || config.memory_limit > 0)) {
+        writer.reset(new AsyncShapeWriter(config));
+        generator.setStream(writer.get());
+    }
+    
+    std::unique_ptr<PhaseProfile> profile;
+    if (config.perf) {
+        profile.reset(new PhaseProfile(config.N));
+        generator.setProfile(profile.get());
+    }
+    
+    std::unique_ptr<ShapeStatistics> statistics;
+    if (config.stats) {
+        statistics.reset(new ShapeStatistics(config.threads, config.type));
+        generator.setStatistics(statistics.get());
+    }
+    
+    std::unique_ptr<SymmetryCensus> census;
+    if (config.symmetry) {
+        census.reset(new SymmetryCensus(config.threads, config.type, config.N));
+        generator.setCensus(census.get());
+    }
+    
+    auto shapes = config.engine == "orderly" ? generator.enumerateOrderly() 
+                                             : generator.enumerate();
+    if (!generator.getError().empty()) {
+        std::cerr << "Error: " << generator.getError() << "\n";
+        return 1;
+    }
     
     // Display and save results
+    PerfCounters output_counters;
+    std::string counter_error;
+    if (profile && !output_counters.open(false, counter_error)) profile->markUnavailable(counter_error);
+    PerfCounters::Sample output_start = output_counters.read();
+    
     OutputManager output_manager(config);
-    output_manager.displayResults(shapes);
+    if (writer) {
+        output_manager.displaySummary(generator.getResultCount());
+        if (!writer->finish()) {
+            std::cerr << "Error: Failed writing " << writer->getPath() << "\n";
+            return 1;
+        }
+        std::cout << "Results saved to " << writer->getPath() << "\n";
+    } else {
+        if (shapes.size() == generator.getResultCount()) {
+            output_manager.displayResults(shapes);
+        } else {
+            output_manager.displaySummary(generator.getResultCount());
+        }
+        
+        if (config.output == "file" || config.output == "both") {
+            output_manager.saveToFile(shapes);
+        } else if (config.output == "binary") {
+            output_manager.saveBinary(shapes);
+        } else if (config.output == "compressed") {
+            output_manager.saveCompressed(shapes);
+        }
+    }
     
-    if (config.output == "file" || config.output == "both") {
-        output_manager.saveToFile(shapes);
+    if (profile) {
+        profile->add(config.N, PhaseProfile::OUTPUT, output_counters.read() - output_start);
+        profile->print(std::cout);
+        if (profile->saveJson(config.perf_file, config)) {
+            std::cout << "Phase counters saved to " << config.perf_file << "\n\n";
+        } else {
+            std::cerr << "Error: Cannot write " << config.perf_file << "\n";
+        }
     }
     
-    // Validate against known values
-    validateResults(config.N, config.type, shapes.size());
+    if (statistics) {
+        statistics->print(std::cout);
+        if (statistics->saveCsv(config.stats_file)) {
+            std::cout << "Statistics saved to " << config.stats_file << "\n\n";
+        } else {
+            std::cerr << "Error: Cannot write " << config.stats_file << "\n";
+        }
+    }
+    
+    if (census) census->print(std::cout);
+    
+    const bool hole_check = config.holes || config.hole_free;
+    const uint64_t holed = generator.getHoledCount();
+    const uint64_t all = generator.getResultCount() + (config.hole_free ? holed : 0);
+    if (hole_check) output_manager.displayHoleCounts(all - holed, holed);
+    
+    // Validate against known values; the census gives the other series too
+    if (!config.hole_free) validateResults(config.N, config.type, all);
+    if (hole_check) validateHoleFree(config.N, config.type, all - holed);
+    if (census) {
+        if (config.type == "free") validateResults(config.N, "one-sided", census->oneSidedCount(config.N));
+        validateResults(config.N, "fixed", census->fixedCount(config.N));
+    }
     
     return 0;
 }
@@ -0,0 +1,4355 @@
+/*
+ * Polyomino Enumerator - header library
+ * 
+ * The shape representation, canonicalization, enumeration and counting
+ * engines and the shape file formats, header-only so other programs can
+ * include them directly. polyomino.cpp is the command-line front end.
+ * 
+ * Everything is declared in namespace polyomino.
+ * 
+ * Streaming API:
+ *   polyomino::enumerate(n, type, visitor) - calls visitor(const Polyomino&) once per
+ *   polyomino of n cells ("free", "one-sided" or "fixed"); a visitor that
+ *   returns false stops the enumeration early.
+ */
+
+#ifndef POLYOMINO_HPP
+#define POLYOMINO_HPP
+
+#include <iostream>
+#include <vector>
+#include <set>
+#include <queue>
+#include <chrono>
+#include <iomanip>
+#include <fstream>
+#include <algorithm>
+#include <string>
+#include <sstream>
+#include <cstdint>
+#include <cstdlib>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <stdexcept>
+
+// AVX2 canonicalization kernel, compiled for x86 GCC/Clang builds and
+// selected at run time when the CPU supports it
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define POLYOMINO_SIMD_CANONICAL 1
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+namespace polyomino {
+
+// Configuration structure
+struct Config {
+    int N = 16;                          // Size of polyominoes
+    std::string type = "free";          // free, one-sided, fixed
+    std::string output = "console";     // console, file, both, binary
+    std::string engine = "bfs";         // bfs, orderly, redelmeier, transfer
+    int threads = 1;                    // Worker threads (bfs engine)
+    bool show_progress = true;          // Display progress updates
+    int progress_interval = 1000;      // Progress update frequency (ms)
+    bool show_summary = true;           // Print the completion summary
+    bool benchmark = false;             // Run the benchmark suite instead
+    std::string checkpoint_file;        // BFS checkpoint path (empty: off)
+    int checkpoint_interval = 600;      // Seconds between checkpoints
+    bool resume = false;                // Continue from checkpoint_file
+    int unit_index = 0;                 // Work unit to run (redelmeier)
+    int unit_count = 1;                 // Number of work units
+    int prefix_depth = 0;               // Shape size where units split (0: auto)
+    std::vector<std::string> merge_files; // Unit files to add up (--merge)
+    uint64_t memory_limit = 0;          // Dedup set budget in bytes (0: none)
+    std::string spill_dir = ".";        // Where spilled runs and levels go
+    bool perf = false;                  // Per-phase hardware counters (bfs)
+    bool stats = false;                 // Shape histograms of every size (bfs)
+    bool symmetry = false;              // Symmetry classes of every size (bfs)
+    int dimension = 2;                  // 2 (polyominoes) or 3 (polycubes, bfs)
+    bool holes = false;                 // Count shapes of size N with and without holes
+    bool hole_free = false;             // List only hole-free shapes of size N
+    std::string stats_file = "polyominoes.stats.csv";
+    std::string perf_file = "polyominoes.perf.json";
+    bool show_shapes = false;           // Display ASCII shapes
+    std::string output_file = "polyominoes.txt";
+    std::string binary_file = "polyominoes.bin";
+    std::string compressed_file = "polyominoes.plyz";
+    std::string input_file;             // Binary shape file to read instead of enumerating
+    std::string rank_shape;             // Shape to look up in input_file (--rank)
+    bool unrank = false;                // Print the shape with id unrank_id
+    uint64_t unrank_id = 0;
+};
+
+// Point structure for coordinates
+struct Point {
+    int x, y;
+    
+    Point(int x = 0, int y = 0) : x(x), y(y) {}
+    
+    bool operator<(const Point& other) const {
+        return x < other.x || (x == other.x && y < other.y);
+    }
+    
+    bool operator==(const Point& other) const {
+        return x == other.x && y == other.y;
+    }
+    
+    Point operator+(const Point& other) const {
+        return Point(x + other.x, y + other.y);
+    }
+};
+
+// Polyomino shape representation - one bitmask word per row (bit x of rows[y]
+// is cell (x, y)) with a bounding-box header, stored inline so copies never
+// allocate. Shapes are kept translated to the origin, so translation,
+// comparison and hashing are word operations over the occupied rows.
+// The row array is fixed, so every shape takes about 116 bytes however few
+// cells it has: this is a working representation, not a storage format.
+// Anything held in bulk (levels, files) is kept as 16-byte ShapeKeys.
+class Polyomino {
+public:
+    static constexpr int MAX_CELLS = 28;  // Rows and row bits available
+    
+private:
+    uint8_t width = 0;                  // Bounding box width
+    uint8_t height = 0;                 // Bounding box height (occupied rows)
+    uint8_t count = 0;                  // Number of cells
+    uint32_t rows[MAX_CELLS] = {};
+    
+public:
+    Polyomino() = default;
+    
+    explicit Polyomino(const std::vector<Point>& points) {
+        if (points.empty()) return;
+        
+        int min_x = points[0].x, min_y = points[0].y;
+        for (const auto& p : points) {
+            min_x = std::min(min_x, p.x);
+            min_y = std::min(min_y, p.y);
+        }
+        
+        for (const auto& p : points) {
+            uint32_t bit = 1u << (p.x - min_x);
+            uint32_t& row = rows[p.y - min_y];
+            if (!(row & bit)) count++;
+            row |= bit;
+        }
+        normalize();
+    }
+    
+    // Parse rows separated by '/', '#' for a cell and anything else for a
+    // gap, first row at y = 0 (e.g. "##/#." is an L tromino)
+    static Polyomino parse(const std::string& text) {
+        std::vector<Point> points;
+        int x = 0, y = 0;
+        for (char c : text) {
+            if (c == '/') {
+                x = 0;
+                y++;
+                continue;
+            }
+            if (c == '#' && x < MAX_CELLS && y < MAX_CELLS) points.push_back(Point(x, y));
+            x++;
+        }
+        return Polyomino(points);
+    }
+    
+    // Build from normalized rows with a known bounding box
+    static Polyomino fromRows(const uint32_t* source, int width, int height, int count) {
+        Polyomino shape;
+        std::copy(source, source + height, shape.rows);
+        shape.width = static_cast<uint8_t>(width);
+        shape.height = static_cast<uint8_t>(height);
+        shape.count = static_cast<uint8_t>(count);
+        return shape;
+    }
+    
+    // Add a cell to the polyomino, shifting the shape if it lies left of or
+    // above the current bounding box
+    void addCell(const Point& p) {
+        int dx = p.x < 0 ? -p.x : 0;
+        int dy = p.y < 0 ? -p.y : 0;
+        
+        if (dy > 0) {
+            for (int y = height - 1; y >= 0; --y) rows[y + dy] = rows[y];
+            for (int y = 0; y < dy; ++y) rows[y] = 0;
+        }
+        if (dx > 0) {
+            for (int y = dy; y < height + dy; ++y) rows[y] <<= dx;
+        }
+        
+        uint32_t bit = 1u << (p.x + dx);
+        uint32_t& row = rows[p.y + dy];
+        if (!(row & bit)) count++;
+        row |= bit;
+        normalize();
+    }
+    
+    // Empty cells edge-adjacent to the shape, in a frame with a one-cell
+    // margin: bit x + 1 of frontier[y + 1] is cell (x, y). Fills height + 2
+    // rows with one shift-and-mask step per row.
+    void getFrontier(uint32_t* frontier) const {
+        uint32_t below = 0, here = 0, above = height > 0 ? rows[0] << 1 : 0;
+        for (int fy = 0; fy < height + 2; ++fy) {
+            frontier[fy] = (here << 1 | here >> 1 | below | above) & ~here;
+            below = here;
+            here = above;
+            above = fy + 1 < height ? rows[fy + 1] << 1 : 0;
+        }
+    }
+    
+    // Copy with the frontier cell at frame position (fx, fy) added; fx == 0
+    // or fy == 0 grow the shape left or down, which shifts it by one
+    Polyomino withFrontierCell(int fx, int fy) const {
+        Polyomino grown;
+        const int sx = fx == 0 ? 1 : 0;
+        const int sy = fy == 0 ? 1 : 0;
+        for (int y = 0; y < height; ++y) grown.rows[y + sy] = rows[y] << sx;
+        grown.rows[fy - 1 + sy] |= 1u << (fx - 1 + sx);
+        grown.width = static_cast<uint8_t>(std::max<int>(width, fx) + sx);
+        grown.height = static_cast<uint8_t>(std::max<int>(height, fy) + sy);
+        grown.count = static_cast<uint8_t>(count + 1);
+        return grown;
+    }
+    
+    // Check whether a cell is occupied
+    bool contains(const Point& p) const {
+        return p.x >= 0 && p.y >= 0 && p.x < width && p.y < height && ((rows[p.y] >> p.x) & 1u);
+    }
+    
+    // Copy with one cell removed, translated back to the origin
+    Polyomino withoutCell(const Point& p) const {
+        Polyomino reduced = *this;
+        if (reduced.contains(p)) {
+            reduced.rows[p.y] &= ~(1u << p.x);
+            reduced.count--;
+            reduced.normalize();
+        }
+        return reduced;
+    }
+    
+    // Grow `reach` to everything 4-connected to it within `open`, a whole
+    // row at a time: each row takes in the reach of its neighbours, then
+    // spreads sideways along its runs
+    static void floodFill(const uint32_t* open, uint32_t* reach, int rows_used) {
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (int y = 0; y < rows_used; ++y) {
+                uint32_t r = reach[y];
+                if (y > 0) r |= reach[y - 1] & open[y];
+                if (y + 1 < rows_used) r |= reach[y + 1] & open[y];
+                
+                // Spread along the row until the run is filled
+                uint32_t grown;
+                while ((grown = (r | (r << 1) | (r >> 1)) & open[y]) != r) r = grown;
+                
+                if (r != reach[y]) {
+                    reach[y] = r;
+                    changed = true;
+                }
+            }
+        }
+    }
+    
+    // Check 4-connectivity by flooding row masks from the first cell
+    bool isConnected() const {
+        if (count == 0) return true;
+        
+        uint32_t reach[MAX_CELLS] = {};
+        reach[0] = rows[0] & (~rows[0] + 1);
+        floodFill(rows, reach, height);
+        
+        for (int y = 0; y < height; ++y) {
+            if (reach[y] != rows[y]) return false;
+        }
+        return true;
+    }
+    
+    // Edge perimeter: four edges per cell, less two per pair of neighbours
+    int getPerimeter() const {
+        int shared = 0;
+        for (int y = 0; y < height; ++y) {
+            shared += popCount(rows[y] & (rows[y] >> 1));
+            if (y + 1 < height) shared += popCount(rows[y] & rows[y + 1]);
+        }
+        return 4 * count - 2 * shared;
+    }
+    
+    // The smallest polyomino with a hole has 7 cells (a ring of 8 less one
+    // corner), and a hole needs at least a 3 x 3 box around it
+    static constexpr int MIN_HOLE_CELLS = 7;
+    
+    bool mayHaveHoles() const {
+        return count >= MIN_HOLE_CELLS && width >= 3 && height >= 3;
+    }
+    
+    // The box with a one-cell empty margin packed into one word, row after
+    // row: bit fy * (width + 2) + fx is set when frame cell (fx, fy) is empty
+    // (cell (x, y) of the shape is frame cell (x + 1, y + 1)). False if the
+    // frame has more than 64 cells.
+    bool packEmptyFrame(uint64_t& empty) const {
+        const int stride = width + 2;
+        const int cells = stride * (height + 2);
+        if (cells > 64) return false;
+        
+        empty = cells == 64 ? ~0ULL : (1ULL << cells) - 1;
+        for (int y = 0; y < height; ++y) {
+            empty &= ~(static_cast<uint64_t>(rows[y]) << ((y + 1) * stride + 1));
+        }
+        return true;
+    }
+    
+    // Word-parallel flood fill of a packed frame: every step moves the
+    // reached set one cell in all four directions at once. Shifts by one
+    // wrap between the last column of a row and the first of the next, but
+    // both are margin cells, which are outside anyway.
+    static uint64_t floodPacked(uint64_t seed, uint64_t open, int stride) {
+        uint64_t reach = seed & open;
+        for (;;) {
+            const uint64_t grown = (reach | reach << 1 | reach >> 1 | reach << stride | reach >> stride) & open;
+            if (grown == reach) return reach;
+            reach = grown;
+        }
+    }
+    
+    // Whether any empty cell is enclosed: flood the outside from a corner of
+    // the margin and look for empty cells it did not reach
+    bool hasHoles() const {
+        if (!mayHaveHoles()) return false;
+        
+        uint64_t empty;
+        if (!packEmptyFrame(empty)) return countHoles() > 0;
+        return (empty & ~floodPacked(1, empty, width + 2)) != 0;
+    }
+    
+    // Number of holes: bounded 4-connected regions of empty cells. The
+    // outside is flooded from the margin, then each region still left takes
+    // one more fill. Frames of up to 64 cells use the packed word; larger
+    // ones fill a row mask at a time.
+    int countHoles() const {
+        if (!mayHaveHoles()) return 0;
+        
+        int holes = 0;
+        uint64_t packed;
+        if (packEmptyFrame(packed)) {
+            const int stride = width + 2;
+            uint64_t enclosed = packed & ~floodPacked(1, packed, stride);
+            for (; enclosed; ++holes) {
+                enclosed &= ~floodPacked(enclosed & (~enclosed + 1), enclosed, stride);
+            }
+            return holes;
+        }
+        
+        uint32_t empty[MAX_CELLS + 2], reach[MAX_CELLS + 2] = {};
+        const int frame_rows = height + 2;
+        const uint32_t frame = (1u << (width + 2)) - 1;
+        for (int fy = 0; fy < frame_rows; ++fy) {
+            empty[fy] = frame & ~(fy > 0 && fy <= height ? rows[fy - 1] << 1 : 0u);
+        }
+        
+        reach[0] = empty[0];
+        floodFill(empty, reach, frame_rows);
+        
+        for (int fy = 1; fy <= height; ++fy) {
+            empty[fy] &= ~reach[fy];
+            reach[fy] = 0;
+        }
+        empty[0] = empty[frame_rows - 1] = 0;
+        reach[0] = reach[frame_rows - 1] = 0;
+        for (int fy = 1; fy <= height; ++fy) {
+            while (empty[fy]) {
+                reach[fy] = empty[fy] & (~empty[fy] + 1);
+                floodFill(empty, reach, frame_rows);
+                for (int y = fy; y <= height; ++y) {
+                    empty[y] &= ~reach[y];
+                    reach[y] = 0;
+                }
+                holes++;
+            }
+        }
+        return holes;
+    }
+    
+    // Get all cells in row-major order
+    std::vector<Point> getCells() const {
+        std::vector<Point> cells;
+        cells.reserve(count);
+        for (int y = 0; y < height; ++y) {
+            for (uint32_t bits = rows[y]; bits; bits &= bits - 1) {
+                cells.emplace_back(countTrailingZeros(bits), y);
+            }
+        }
+        return cells;
+    }
+    
+    // Get size
+    size_t size() const { return count; }
+    
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    uint32_t getRow(int y) const { return rows[y]; }
+    
+    // Normalize: translate to origin and recompute the bounding box
+    void normalize() {
+        int first = 0;
+        while (first < MAX_CELLS && rows[first] == 0) ++first;
+        if (first == MAX_CELLS) {
+            width = height = 0;
+            return;
+        }
+        
+        int last = MAX_CELLS - 1;
+        while (rows[last] == 0) --last;
+        
+        uint32_t all = 0;
+        for (int y = first; y <= last; ++y) all |= rows[y];
+        int shift = countTrailingZeros(all);
+        
+        for (int y = first; y <= last; ++y) rows[y - first] = rows[y] >> shift;
+        for (int y = last - first + 1; y <= last; ++y) rows[y] = 0;
+        
+        height = static_cast<uint8_t>(last - first + 1);
+        width = static_cast<uint8_t>(32 - countLeadingZeros(all >> shift));
+    }
+    
+    // Generate rotated version (90 degrees clockwise)
+    Polyomino rotate() const {
+        Polyomino rotated;
+        for (int y = 0; y < height; ++y) {
+            for (uint32_t bits = rows[y]; bits; bits &= bits - 1) {
+                int x = countTrailingZeros(bits);
+                rotated.rows[width - 1 - x] |= 1u << y;
+            }
+        }
+        rotated.width = height;
+        rotated.height = width;
+        rotated.count = count;
+        return rotated;
+    }
+    
+    // Generate reflected version (horizontal flip)
+    Polyomino reflect() const {
+        Polyomino reflected;
+        for (int y = 0; y < height; ++y) {
+            for (uint32_t bits = rows[y]; bits; bits &= bits - 1) {
+                int x = countTrailingZeros(bits);
+                reflected.rows[y] |= 1u << (width - 1 - x);
+            }
+        }
+        reflected.width = width;
+        reflected.height = height;
+        reflected.count = count;
+        return reflected;
+    }
+    
+    // Get hash for deduplication
+    size_t getHash() const {
+        size_t hash = width;
+        for (int y = 0; y < height; ++y) {
+            hash ^= rows[y] + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        }
+        return hash;
+    }
+    
+    // Equality comparison
+    bool operator==(const Polyomino& other) const {
+        if (height != other.height) return false;
+        for (int y = 0; y < height; ++y) {
+            if (rows[y] != other.rows[y]) return false;
+        }
+        return true;
+    }
+    
+    // Less than comparison for sets: width first, then rows compared
+    // lexicographically as words (the order of ShapeKey)
+    bool operator<(const Polyomino& other) const {
+        if (width != other.width) return width < other.width;
+        int rows_used = std::max(height, other.height);
+        for (int y = 0; y < rows_used; ++y) {
+            if (rows[y] != other.rows[y]) return rows[y] < other.rows[y];
+        }
+        return false;
+    }
+    
+    // Convert to string for output
+    std::string toString() const {
+        std::string result;
+        appendText(result);
+        return result;
+    }
+    
+    // Append the toString() rendering to an existing buffer
+    void appendText(std::string& out) const {
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                out += ((rows[y] >> x) & 1u) ? '#' : ' ';
+            }
+            out += '\n';
+        }
+    }
+    
+    // Bit scans on non-zero words
+    static int countTrailingZeros(uint32_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctz(v);
+#else
+        int n = 0;
+        while (!(v & 1u)) { v >>= 1; ++n; }
+        return n;
+#endif
+    }
+    
+    static int popCount(uint32_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_popcount(v);
+#else
+        int n = 0;
+        for (; v; v &= v - 1) ++n;
+        return n;
+#endif
+    }
+    
+    static int countTrailingZeros64(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctzll(v);
+#else
+        int n = 0;
+        while (!(v & 1u)) { v >>= 1; ++n; }
+        return n;
+#endif
+    }
+    
+    static int popCount64(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_popcountll(v);
+#else
+        int n = 0;
+        for (; v; v &= v - 1) ++n;
+        return n;
+#endif
+    }
+    
+    static int countLeadingZeros(uint32_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_clz(v);
+#else
+        int n = 0;
+        while (!(v & 0x80000000u)) { v <<= 1; ++n; }
+        return n;
+#endif
+    }
+};
+
+// Compact canonical encoding - the shape packed MSB-first into 128 bits:
+// 5 bits of (width - 1), then each row's `width` bits in row order. Rows are
+// never empty, so the height follows from the packing. Every shape with
+// width * height <= 123 fits, which covers all shapes up to 21 cells. Key
+// order matches Polyomino order, and the all-zero key is never a shape.
+struct ShapeKey {
+    static constexpr int MAX_CELLS = 21;
+    
+    uint64_t hi = 0, lo = 0;
+    
+    static ShapeKey fromShape(const Polyomino& shape) {
+        ShapeKey key;
+        const int w = shape.getWidth();
+        key.put(0, 5, static_cast<uint64_t>(w - 1));
+        for (int y = 0; y < shape.getHeight(); ++y) {
+            key.put(5 + y * w, w, shape.getRow(y));
+        }
+        return key;
+    }
+    
+    Polyomino toShape() const {
+        const int w = static_cast<int>(get(0, 5)) + 1;
+        uint32_t rows[Polyomino::MAX_CELLS];
+        int h = 0, cells = 0;
+        for (int pos = 5; pos + w <= 128; pos += w) {
+            uint32_t row = static_cast<uint32_t>(get(pos, w));
+            if (!row) break;
+            rows[h++] = row;
+            for (uint32_t bits = row; bits; bits &= bits - 1) cells++;
+        }
+        return Polyomino::fromRows(rows, w, h, cells);
+    }
+    
+    bool empty() const { return !hi && !lo; }
+    
+    uint64_t hash() const {
+        uint64_t h = hi * 0x9e3779b97f4a7c15ULL ^ lo;
+        h ^= h >> 31;
+        h *= 0xbf58476d1ce4e5b9ULL;
+        return h ^ (h >> 29);
+    }
+    
+    bool operator==(const ShapeKey& other) const {
+        return hi == other.hi && lo == other.lo;
+    }
+    
+    bool operator!=(const ShapeKey& other) const { return !(*this == other); }
+    
+    bool operator<(const ShapeKey& other) const {
+        return hi < other.hi || (hi == other.hi && lo < other.lo);
+    }
+    
+private:
+    // Field of n bits starting `pos` bits below the top of the key
+    void put(int pos, int n, uint64_t value) {
+        int shift = 128 - pos - n;
+        if (shift >= 64) {
+            hi |= value << (shift - 64);
+        } else {
+            lo |= value << shift;
+            if (shift + n > 64) hi |= value >> (64 - shift);
+        }
+    }
+    
+    uint64_t get(int pos, int n) const {
+        int shift = 128 - pos - n;
+        uint64_t value;
+        if (shift >= 64) {
+            value = hi >> (shift - 64);
+        } else {
+            value = lo >> shift;
+            if (shift + n > 64) value |= hi << (64 - shift);
+        }
+        return value & ((1ULL << n) - 1);
+    }
+};
+
+// Canonical form of a shape together with its symmetry count
+struct CanonicalForm {
+    Polyomino shape;                    // Smallest image under the symmetry group
+    int stabilizer = 1;                 // Group elements mapping the shape onto itself
+    unsigned tied = 1;                  // Bit k: element k's image is `shape`
+};
+
+// Shape canonicalizer - handles symmetries
+class ShapeNormalizer {
+private:
+    std::string enumeration_type;
+    int group_size;                     // 1 (fixed), 4 rotations (one-sided), 8 (free)
+    bool use_simd;                      // Dispatch to the vector kernel
+    
+#ifdef POLYOMINO_SIMD_CANONICAL
+    // Reverse the bits of every 32-bit lane: bytes are swapped with a
+    // shuffle, then each byte is reversed one nibble at a time via a table
+    __attribute__((target("avx2")))
+    static __m256i reverseBits(__m256i v) {
+        const __m256i byte_swap = _mm256_setr_epi8(
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+        const __m256i nibble_rev = _mm256_setr_epi8(
+            0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15,
+            0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15);
+        const __m256i low = _mm256_set1_epi8(0x0F);
+        
+        v = _mm256_shuffle_epi8(v, byte_swap);
+        __m256i lo = _mm256_shuffle_epi8(nibble_rev, _mm256_and_si256(v, low));
+        __m256i hi = _mm256_shuffle_epi8(nibble_rev, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+        return _mm256_or_si256(_mm256_slli_epi16(lo, 4), hi);
+    }
+#endif
+    
+public:
+    explicit ShapeNormalizer(const std::string& type) 
+        : enumeration_type(type), 
+          group_size(type == "free" ? 8 : type == "one-sided" ? 4 : 1),
+          use_simd(simdAvailable()) {}
+    
+    // Whether this build and CPU can run the vector kernel
+    static bool simdAvailable() {
+#ifdef POLYOMINO_SIMD_CANONICAL
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    }
+    
+    // Canonicalize under the enumeration type's group, with the vector
+    // kernel when available
+    CanonicalForm canonicalize(const Polyomino& shape) const {
+#ifdef POLYOMINO_SIMD_CANONICAL
+        if (use_simd && group_size > 1) return canonicalizeSimd(shape);
+#endif
+        return canonicalizeScalar(shape);
+    }
+    
+    // Scalar kernel. All images are built in one pass over the cells into
+    // stack buffers (rotations first, then the reflections) and compared row
+    // by row with early exit.
+    CanonicalForm canonicalizeScalar(const Polyomino& shape) const {
+        CanonicalForm result;
+        if (group_size == 1) {
+            result.shape = shape;
+            return result;
+        }
+        
+        const int w = shape.getWidth();
+        const int h = shape.getHeight();
+        const int span = std::max(w, h);
+        
+        uint32_t images[8][Polyomino::MAX_CELLS];
+        for (int k = 0; k < group_size; ++k) {
+            std::fill(images[k], images[k] + span, 0u);
+        }
+        
+        for (int y = 0; y < h; ++y) {
+            for (uint32_t bits = shape.getRow(y); bits; bits &= bits - 1) {
+                const int x = Polyomino::countTrailingZeros(bits);
+                const int rx = w - 1 - x, ry = h - 1 - y;
+                images[0][y]  |= 1u << x;       // Identity
+                images[1][rx] |= 1u << y;       // Rotate 90 clockwise
+                images[2][ry] |= 1u << rx;      // Rotate 180
+                images[3][x]  |= 1u << ry;      // Rotate 270
+                if (group_size == 8) {
+                    images[4][y]  |= 1u << rx;  // Horizontal flip
+                    images[5][x]  |= 1u << y;   // Transpose
+                    images[6][ry] |= 1u << x;   // Vertical flip
+                    images[7][rx] |= 1u << ry;  // Anti-transpose
+                }
+            }
+        }
+        
+        int best = 0;
+        for (int k = 1; k < group_size; ++k) {
+            int y = 0;
+            while (y < span && images[k][y] == images[best][y]) ++y;
+            
+            if (y == span) {
+                result.stabilizer++;
+                result.tied |= 1u << k;
+            } else if (images[k][y] < images[best][y]) {
+                best = k;
+                result.stabilizer = 1;
+                result.tied = 1u << k;
+            }
+        }
+        
+        // Odd elements swap the box dimensions
+        const bool swapped = (best & 1) != 0;
+        result.shape = Polyomino::fromRows(images[best], swapped ? h : w, swapped ? w : h,
+                                           static_cast<int>(shape.size()));
+        return result;
+    }
+    
+#ifdef POLYOMINO_SIMD_CANONICAL
+    // Vector kernel - one AVX2 lane per group element, so row r of all eight
+    // images sits in one register. The columns (transposed rows) are built
+    // eight at a time with variable shifts; each image row is then a lane
+    // blend of rows, columns and their bit reversals. The lexicographic
+    // minimum is found without branches: a lane mask of images still tied
+    // for smallest is narrowed row by row with a horizontal minimum. Lanes
+    // left at the end are the stabilizer, and the lowest one is the same
+    // image the scalar kernel picks.
+    __attribute__((target("avx2")))
+    CanonicalForm canonicalizeSimd(const Polyomino& shape) const {
+        CanonicalForm result;
+        if (group_size == 1) {
+            result.shape = shape;
+            return result;
+        }
+        
+        const int w = shape.getWidth();
+        const int h = shape.getHeight();
+        const int span = std::max(w, h);
+        
+        // Rows and columns with 32 zero words of margin on each side, so
+        // rows past the shape (and negative indices) read as empty
+        constexpr int PAD = 32;
+        alignas(32) uint32_t row[PAD + 64 + PAD];
+        alignas(32) uint32_t col[PAD + 64 + PAD];
+        std::fill(row + PAD - span, row + PAD + span, 0u);
+        std::fill(col + PAD - span, col + PAD + span + 8, 0u);
+        for (int y = 0; y < h; ++y) row[PAD + y] = shape.getRow(y);
+        
+        // col[x] bit y = row[y] bit x
+        const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m256i one = _mm256_set1_epi32(1);
+        for (int xb = 0; xb < w; xb += 8) {
+            const __m256i xs = _mm256_add_epi32(lane, _mm256_set1_epi32(xb));
+            __m256i acc = _mm256_setzero_si256();
+            for (int y = 0; y < h; ++y) {
+                __m256i bit = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(static_cast<int>(row[PAD + y])), xs), one);
+                acc = _mm256_or_si256(acc, _mm256_sll_epi32(bit, _mm_cvtsi32_si128(y)));
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(col + PAD + xb), acc);
+        }
+        
+        // Reversed lanes: rotate 180 and horizontal flip reverse a row within
+        // the width, rotate 270 and anti-transpose reverse a column within
+        // the height
+        const __m256i reverse_shift = _mm256_setr_epi32(0, 0, 32 - w, 32 - h, 32 - w, 0, 0, 32 - h);
+        const __m256i all = _mm256_set1_epi32(-1);
+        __m256i alive = group_size == 8 ? all : _mm256_setr_epi32(-1, -1, -1, -1, 0, 0, 0, 0);
+        alignas(32) uint32_t images[Polyomino::MAX_CELLS][8];
+        
+        for (int r = 0; r < span; ++r) {
+            const uint32_t* fwd = row + PAD + r;
+            const uint32_t* bwd = row + PAD + h - 1 - r;
+            const uint32_t* cfwd = col + PAD + r;
+            const uint32_t* cbwd = col + PAD + w - 1 - r;
+            __m256i v = _mm256_setr_epi32(
+                static_cast<int>(*fwd),     // Identity
+                static_cast<int>(*cbwd),    // Rotate 90 clockwise
+                static_cast<int>(*bwd),     // Rotate 180 (reversed)
+                static_cast<int>(*cfwd),    // Rotate 270 (reversed)
+                static_cast<int>(*fwd),     // Horizontal flip (reversed)
+                static_cast<int>(*cfwd),    // Transpose
+                static_cast<int>(*bwd),     // Vertical flip
+                static_cast<int>(*cbwd));   // Anti-transpose (reversed)
+            __m256i reversed = _mm256_srlv_epi32(reverseBits(v), reverse_shift);
+            v = _mm256_blend_epi32(v, reversed, 0x9C);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(images[r]), v);
+            
+            // Lanes out of the running read as all ones and never match
+            __m256i masked = _mm256_or_si256(v, _mm256_andnot_si256(alive, all));
+            __m256i low = _mm256_min_epu32(masked, _mm256_permute2x128_si256(masked, masked, 1));
+            low = _mm256_min_epu32(low, _mm256_shuffle_epi32(low, 0x4E));
+            low = _mm256_min_epu32(low, _mm256_shuffle_epi32(low, 0xB1));
+            alive = _mm256_and_si256(alive, _mm256_cmpeq_epi32(masked, low));
+        }
+        
+        const unsigned tied = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(alive)));
+        const int best = __builtin_ctz(tied);
+        result.stabilizer = __builtin_popcount(tied);
+        result.tied = tied;
+        
+        uint32_t best_rows[Polyomino::MAX_CELLS];
+        for (int r = 0; r < span; ++r) best_rows[r] = images[r][best];
+        
+        // Odd elements swap the box dimensions
+        const bool swapped = (best & 1) != 0;
+        result.shape = Polyomino::fromRows(best_rows, swapped ? h : w, swapped ? w : h,
+                                           static_cast<int>(shape.size()));
+        return result;
+    }
+#endif
+    
+    // Symmetry classes: the subgroups of D4 up to conjugacy, i.e. which
+    // symmetries a shape has regardless of how it is turned
+    enum SymmetryClass {
+        SYM_NONE, SYM_MIRROR90, SYM_MIRROR45, SYM_ROT2, SYM_ROT4,
+        SYM_MIRROR90X2, SYM_MIRROR45X2, SYM_ALL, SYMMETRY_CLASSES
+    };
+    
+    static const char* symmetryClassName(int c) {
+        static const char* const names[SYMMETRY_CLASSES] = {
+            "none", "mirror90", "mirror45", "rot2", "rot4", "mirror90x2", "mirror45x2", "all"};
+        return names[c];
+    }
+    
+    // Order of the stabilizer subgroup, and whether it holds a reflection
+    static int symmetryClassOrder(int c) {
+        return c == SYM_NONE ? 1 : c == SYM_ALL ? 8 : c <= SYM_ROT2 ? 2 : 4;
+    }
+    
+    static bool symmetryClassReflects(int c) {
+        return c != SYM_NONE && c != SYM_ROT2 && c != SYM_ROT4;
+    }
+    
+    // Element k as the matrix {a, b, c, d} with x' = a x + b y, y' = c x + d y
+    // (y pointing down), in the order the kernels use
+    static const int* groupElement(int k) {
+        static const int elements[8][4] = {
+            {1, 0, 0, 1},                   // Identity
+            {0, 1, -1, 0},                  // Rotate 90 clockwise
+            {-1, 0, 0, -1},                 // Rotate 180
+            {0, -1, 1, 0},                  // Rotate 270
+            {-1, 0, 0, 1},                  // Horizontal flip
+            {0, 1, 1, 0},                   // Transpose
+            {1, 0, 0, -1},                  // Vertical flip
+            {0, -1, -1, 0}};                // Anti-transpose
+        return elements[k];
+    }
+    
+    // Stabilizer subgroup of the shape that was canonicalized, as a mask of
+    // elements. With t0 the lowest tied element, g fixes the shape exactly
+    // when t0 g is tied, so the subgroup is t0^-1 applied to the tied set.
+    static unsigned stabilizerMask(const CanonicalForm& form) {
+        const int* t0 = groupElement(Polyomino::countTrailingZeros(form.tied));
+        unsigned mask = 0;
+        for (unsigned bits = form.tied; bits; bits &= bits - 1) {
+            const int* t = groupElement(Polyomino::countTrailingZeros(bits));
+            // t0 is orthogonal, so its inverse is its transpose
+            const int m[4] = {t0[0] * t[0] + t0[2] * t[2], t0[0] * t[1] + t0[2] * t[3],
+                              t0[1] * t[0] + t0[3] * t[2], t0[1] * t[1] + t0[3] * t[3]};
+            for (int k = 0; k < 8; ++k) {
+                const int* g = groupElement(k);
+                if (g[0] == m[0] && g[1] == m[1] && g[2] == m[2] && g[3] == m[3]) mask |= 1u << k;
+            }
+        }
+        return mask;
+    }
+    
+    // Symmetry class of a stabilizer mask: its order and the kinds of
+    // element in it are enough to tell the eight apart
+    static int symmetryClass(unsigned stabilizer) {
+        const bool quarter = stabilizer & 0x0A;     // Rotate 90 or 270
+        const bool axis = stabilizer & 0x50;        // Horizontal or vertical flip
+        const bool diagonal = stabilizer & 0xA0;    // Transpose or anti-transpose
+        switch (Polyomino::popCount(stabilizer)) {
+            case 1: return SYM_NONE;
+            case 2: return axis ? SYM_MIRROR90 : diagonal ? SYM_MIRROR45 : SYM_ROT2;
+            case 4: return quarter ? SYM_ROT4 : axis ? SYM_MIRROR90X2 : SYM_MIRROR45X2;
+            default: return SYM_ALL;
+        }
+    }
+    
+    // Get canonical form considering symmetries
+    Polyomino getCanonical(const Polyomino& shape) const {
+        return canonicalize(shape).shape;
+    }
+    
+    // Canonical parent for orderly generation: drop the last cell (in
+    // row-major order of the canonical form) whose removal keeps the shape
+    // connected, then canonicalize. Depends only on the shape's class.
+    Polyomino canonicalParent(const Polyomino& canonical) const {
+        auto cells = canonical.getCells();
+        for (auto it = cells.rbegin(); it != cells.rend(); ++it) {
+            Polyomino parent = canonical.withoutCell(*it);
+            if (parent.isConnected()) {
+                return getCanonical(parent);
+            }
+        }
+        return Polyomino();
+    }
+};
+
+// Progress tracker
+class ProgressTracker {
+private:
+    std::chrono::high_resolution_clock::time_point start_time;
+    std::chrono::high_resolution_clock::time_point last_update;
+    int update_interval_ms;
+    bool enabled;
+    bool summary;
+    
+public:
+    ProgressTracker(bool enabled = true, int interval_ms = 1000, bool summary = true) 
+        : update_interval_ms(interval_ms), enabled(enabled), summary(summary) {
+        start_time = std::chrono::high_resolution_clock::now();
+        last_update = start_time;
+    }
+    
+    void update(int current_size, size_t unique_count, size_t total_generated) {
+        if (!enabled) return;
+        
+        auto now = std::chrono::high_resolution_clock::now();
+        auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_update).count();
+        
+        if (elapsed_ms >= update_interval_ms) {
+            auto total_elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - start_time).count();
+            
+            std::cout << "\r[Size " << current_size << "] "
+                      << "Unique: " << unique_count << " | "
+                      << "Generated: " << total_generated << " | "
+                      << "Time: " << (total_elapsed_ms / 1000.0) << "s"
+                      << std::flush;
+            
+            last_update = now;
+        }
+    }
+    
+    // `shapes` names what was counted in the summary line
+    void finish(size_t final_count, const char* shapes = "polyominoes") {
+        auto end_time = std::chrono::high_resolution_clock::now();
+        auto total_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+        
+        if (enabled) {
+            std::cout << "\r" << std::string(80, ' ') << "\r"; // Clear progress line
+        }
+        
+        if (!summary) return;
+        
+        std::cout << "✓ Enumeration completed in " << (total_time / 1000.0) << " seconds\n";
+        std::cout << "✓ Found " << final_count << " unique " << shapes << "\n";
+    }
+};
+
+// Work-stealing pool - splits [0, count) into chunks and gives each worker a
+// contiguous slice of them. Workers claim chunks from their own slice first
+// and steal from the other slices once it runs dry, so uneven chunks balance
+// out without a shared queue.
+class WorkStealingPool {
+private:
+    struct alignas(64) Slice {
+        std::atomic<size_t> next{0};
+        size_t end = 0;
+    };
+    
+    int thread_count;
+    
+public:
+    explicit WorkStealingPool(int threads) : thread_count(std::max(1, threads)) {}
+    
+    int size() const { return thread_count; }
+    
+    // Run task(worker, begin, end) over every chunk of [0, count). The calling
+    // thread waits and runs poll() about every 100 ms until all workers finish.
+    void run(size_t count, size_t grain,
+             const std::function<void(int, size_t, size_t)>& task,
+             const std::function<void()>& poll = nullptr) {
+        grain = std::max<size_t>(1, grain);
+        const size_t chunks = (count + grain - 1) / grain;
+        
+        std::vector<Slice> slices(thread_count);
+        for (int w = 0; w < thread_count; ++w) {
+            slices[w].next = chunks * w / thread_count;
+            slices[w].end = chunks * (w + 1) / thread_count;
+        }
+        
+        std::mutex mutex;
+        std::condition_variable finished;
+        int running = thread_count;
+        
+        auto worker = [&](int w) {
+            for (int k = 0; k < thread_count; ++k) {
+                Slice& slice = slices[(w + k) % thread_count];
+                size_t chunk;
+                while ((chunk = slice.next.fetch_add(1)) < slice.end) {
+                    size_t begin = chunk * grain;
+                    task(w, begin, std::min(count, begin + grain));
+                }
+            }
+            
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--running == 0) finished.notify_one();
+        };
+        
+        std::vector<std::thread> threads;
+        for (int w = 0; w < thread_count; ++w) {
+            threads.emplace_back(worker, w);
+        }
+        
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (running > 0) {
+                finished.wait_for(lock, std::chrono::milliseconds(100));
+                if (poll && running > 0) {
+                    lock.unlock();
+                    poll();
+                    lock.lock();
+                }
+            }
+        }
+        
+        for (auto& t : threads) t.join();
+    }
+};
+
+// Arena for one BFS level - a single contiguous block of fixed-width ShapeKey
+// records. Space is reserved once per level and records are written in
+// place; release() frees the whole level with one deallocation.
+class LevelStore {
+private:
+    std::unique_ptr<ShapeKey[]> block;
+    size_t capacity = 0;
+    size_t count = 0;
+    
+public:
+    LevelStore() = default;
+    LevelStore(LevelStore&&) = default;
+    LevelStore& operator=(LevelStore&&) = default;
+    
+    // Make room for n records in total, moving existing ones if needed
+    void reserve(size_t n) {
+        if (n <= capacity) return;
+        std::unique_ptr<ShapeKey[]> grown(new ShapeKey[n]);
+        std::copy(begin(), end(), grown.get());
+        block.swap(grown);
+        capacity = n;
+    }
+    
+    // Set the record count, e.g. before filling data() directly
+    void resize(size_t n) {
+        reserve(n);
+        count = n;
+    }
+    
+    void push_back(const ShapeKey& key) {
+        if (count == capacity) reserve(std::max<size_t>(64, 2 * capacity));
+        block[count++] = key;
+    }
+    
+    void release() {
+        block.reset();
+        capacity = count = 0;
+    }
+    
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    ShapeKey* data() { return block.get(); }
+    const ShapeKey* data() const { return block.get(); }
+    ShapeKey* begin() { return block.get(); }
+    ShapeKey* end() { return block.get() + count; }
+    const ShapeKey* begin() const { return block.get(); }
+    const ShapeKey* end() const { return block.get() + count; }
+    ShapeKey& operator[](size_t i) { return block[i]; }
+    const ShapeKey& operator[](size_t i) const { return block[i]; }
+};
+
+// Concurrent set of shape keys - open addressing with linear probing, split
+// into shards by the top bits of the key hash. Each shard has its own lock
+// and table and grows independently, so threads only contend when they hit
+// the same shard. drainSorted() empties the set into one sorted vector for
+// deterministic output.
+class ShardedShapeSet {
+private:
+    struct alignas(64) Shard {
+        std::mutex lock;
+        std::vector<ShapeKey> slots;    // Empty slots hold the zero key
+        size_t used = 0;
+    };
+    
+    int shard_bits;
+    std::unique_ptr<Shard[]> shards;
+    std::atomic<size_t> total{0};
+    
+    static void place(std::vector<ShapeKey>& slots, const ShapeKey& key, uint64_t hash) {
+        size_t mask = slots.size() - 1;
+        size_t i = static_cast<size_t>(hash) & mask;
+        while (!slots[i].empty()) i = (i + 1) & mask;
+        slots[i] = key;
+    }
+    
+public:
+    explicit ShardedShapeSet(int bits = 8) 
+        : shard_bits(bits), shards(new Shard[size_t(1) << bits]) {
+        for (size_t s = 0; s < shardCount(); ++s) shards[s].slots.resize(64);
+    }
+    
+    size_t shardCount() const { return size_t(1) << shard_bits; }
+    
+    size_t size() const { return total.load(std::memory_order_relaxed); }
+    
+    // Insert a key; returns true if it was not present
+    bool insert(const ShapeKey& key) {
+        const uint64_t hash = key.hash();
+        Shard& shard = shards[hash >> (64 - shard_bits)];
+        std::lock_guard<std::mutex> guard(shard.lock);
+        
+        size_t mask = shard.slots.size() - 1;
+        for (size_t i = static_cast<size_t>(hash) & mask; !shard.slots[i].empty(); i = (i + 1) & mask) {
+            if (shard.slots[i] == key) return false;
+        }
+        
+        // Keep the load factor under 3/4
+        if (4 * (shard.used + 1) > 3 * shard.slots.size()) {
+            std::vector<ShapeKey> grown(2 * shard.slots.size());
+            for (const auto& k : shard.slots) {
+                if (!k.empty()) place(grown, k, k.hash());
+            }
+            shard.slots.swap(grown);
+        }
+        place(shard.slots, key, hash);
+        shard.used++;
+        total.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    
+    // Bytes held by the shard tables; the set must not be modified concurrently
+    size_t bytes() const {
+        size_t total_bytes = 0;
+        for (size_t s = 0; s < shardCount(); ++s) total_bytes += shards[s].slots.size() * sizeof(ShapeKey);
+        return total_bytes;
+    }
+    
+    // Copy of every key in no particular order; the set must not be
+    // modified concurrently
+    std::vector<ShapeKey> keys() const {
+        std::vector<ShapeKey> all;
+        all.reserve(size());
+        for (size_t s = 0; s < shardCount(); ++s) {
+            for (const auto& k : shards[s].slots) {
+                if (!k.empty()) all.push_back(k);
+            }
+        }
+        return all;
+    }
+    
+    // Remove every key and pass them to emit(key) in ascending order. Shards
+    // are compacted into one scratch block and sorted in parallel, then
+    // merged with a heap; the set keeps no storage afterwards.
+    template <typename Emit>
+    void drainSorted(Emit emit, int threads = 1) {
+        std::vector<size_t> offsets(shardCount() + 1, 0);
+        for (size_t s = 0; s < shardCount(); ++s) offsets[s + 1] = offsets[s] + shards[s].used;
+        
+        LevelStore scratch;
+        scratch.resize(offsets.back());
+        
+        WorkStealingPool pool(threads);
+        pool.run(shardCount(), 1, [&](int, size_t s, size_t) {
+            Shard& shard = shards[s];
+            ShapeKey* run = scratch.data() + offsets[s];
+            for (const auto& k : shard.slots) {
+                if (!k.empty()) *run++ = k;
+            }
+            std::vector<ShapeKey>(64).swap(shard.slots);
+            shard.used = 0;
+            std::sort(scratch.data() + offsets[s], run);
+        });
+        
+        using Head = std::pair<ShapeKey, size_t>;
+        auto greater = [](const Head& a, const Head& b) { return b.first < a.first; };
+        std::vector<Head> heap;
+        std::vector<size_t> pos(offsets.begin(), offsets.end() - 1);
+        for (size_t r = 0; r < shardCount(); ++r) {
+            if (pos[r] < offsets[r + 1]) heap.emplace_back(scratch[pos[r]], r);
+        }
+        std::make_heap(heap.begin(), heap.end(), greater);
+        
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), greater);
+            size_t r = heap.back().second;
+            emit(heap.back().first);
+            heap.pop_back();
+            
+            if (++pos[r] < offsets[r + 1]) {
+                heap.emplace_back(scratch[pos[r]], r);
+                std::push_heap(heap.begin(), heap.end(), greater);
+            }
+        }
+        
+        total = 0;
+    }
+    
+    // Remove every key and store them in `out` in ascending order
+    void drainSorted(LevelStore& out, int threads = 1) {
+        out.release();
+        out.reserve(size());
+        drainSorted([&](const ShapeKey& key) { out.push_back(key); }, threads);
+    }
+};
+
+// Binary shape file - a 32-byte little-endian header followed by `count`
+// fixed-width ShapeKey records (hi word, then lo word) in ascending order.
+// Records start 8-byte aligned, so a mapped file can be read in place.
+struct ShapeFileHeader {
+    char magic[4];                      // "PLYB"
+    uint16_t version;                   // Encoding version
+    uint16_t key_bytes;                 // Bytes per record
+    uint32_t n;                         // Polyomino size
+    uint32_t type;                      // 0 free, 1 one-sided, 2 fixed
+    uint64_t count;                     // Number of records
+    uint64_t reserved;
+    
+    static constexpr uint16_t VERSION = 1;
+    
+    static uint32_t typeCode(const std::string& type) {
+        return type == "free" ? 0 : type == "one-sided" ? 1 : 2;
+    }
+    
+    static std::string typeName(uint32_t code) {
+        return code == 0 ? "free" : code == 1 ? "one-sided" : "fixed";
+    }
+};
+
+static_assert(sizeof(ShapeFileHeader) == 32, "shape file header must be 32 bytes");
+static_assert(sizeof(ShapeKey) == 16, "shape file records must be 16 bytes");
+
+// Streaming writer for binary shape files; keys must arrive in ascending
+// order. The record count is patched into the header on close().
+class ShapeFileWriter {
+private:
+    FILE* file = nullptr;
+    ShapeFileHeader header{};
+    std::vector<ShapeKey> buffer;
+    
+    bool flush() {
+        if (buffer.empty()) return true;
+        bool ok = std::fwrite(buffer.data(), sizeof(ShapeKey), buffer.size(), file) == buffer.size();
+        buffer.clear();
+        return ok;
+    }
+    
+public:
+    ShapeFileWriter() = default;
+    ShapeFileWriter(const ShapeFileWriter&) = delete;
+    ShapeFileWriter& operator=(const ShapeFileWriter&) = delete;
+    
+    ~ShapeFileWriter() { close(); }
+    
+    bool open(const std::string& path, int n, const std::string& type) {
+        file = std::fopen(path.c_str(), "wb");
+        if (!file) return false;
+        
+        std::memcpy(header.magic, "PLYB", 4);
+        header.version = ShapeFileHeader::VERSION;
+        header.key_bytes = sizeof(ShapeKey);
+        header.n = static_cast<uint32_t>(n);
+        header.type = ShapeFileHeader::typeCode(type);
+        header.count = 0;
+        buffer.reserve(1 << 16);
+        return std::fwrite(&header, sizeof(header), 1, file) == 1;
+    }
+    
+    void write(const ShapeKey& key) {
+        buffer.push_back(key);
+        header.count++;
+        if (buffer.size() == buffer.capacity()) flush();
+    }
+    
+    bool close() {
+        if (!file) return true;
+        bool ok = flush();
+        ok = ok && std::fseek(file, 0, SEEK_SET) == 0;
+        ok = ok && std::fwrite(&header, sizeof(header), 1, file) == 1;
+        ok = std::fclose(file) == 0 && ok;
+        file = nullptr;
+        return ok;
+    }
+};
+
+// Read-only view of a whole file - memory-mapped where the platform allows,
+// read into memory otherwise.
+class MappedFile {
+private:
+    const uint8_t* bytes = nullptr;
+    size_t length = 0;
+#if defined(__unix__) || defined(__APPLE__)
+    void* mapping = nullptr;
+    size_t dropped = 0;                 // Prefix already handed back by dropBefore
+#else
+    std::vector<uint8_t> storage;
+#endif
+    
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    ~MappedFile() { release(); }
+    
+    void release() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (mapping) munmap(mapping, length);
+        mapping = nullptr;
+        dropped = 0;
+#else
+        storage.clear();
+#endif
+        bytes = nullptr;
+        length = 0;
+    }
+    
+    // Map a file; on failure `error` says why
+    bool open(const std::string& path, std::string& error) {
+        release();
+#if defined(__unix__) || defined(__APPLE__)
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            error = "cannot open " + path;
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            ::close(fd);
+            error = path + " is empty";
+            return false;
+        }
+        length = static_cast<size_t>(info.st_size);
+        mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            mapping = nullptr;
+            length = 0;
+            error = "cannot map " + path;
+            return false;
+        }
+        bytes = static_cast<const uint8_t*>(mapping);
+#else
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            error = "cannot open " + path;
+            return false;
+        }
+        storage.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        if (storage.empty()) {
+            error = path + " is empty";
+            return false;
+        }
+        bytes = storage.data();
+        length = storage.size();
+#endif
+        return true;
+    }
+    
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+    
+    // Release the pages of bytes [0, end) of a file read front to back, so
+    // a sequential scan keeps only the pages ahead of it resident
+    void dropBefore(size_t end) {
+#if defined(__unix__) || defined(__APPLE__)
+        const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        end = std::min(end, length) / page * page;
+        if (mapping && end > dropped) {
+            madvise(static_cast<uint8_t*>(mapping) + dropped, end - dropped, MADV_DONTNEED);
+            dropped = end;
+        }
+#else
+        (void)end;
+#endif
+    }
+};
+
+// Zero-copy reader for binary shape files; records are served straight
+// from the mapping.
+class MappedShapeFile {
+private:
+    MappedFile file;
+    
+    const ShapeFileHeader& header() const {
+        return *reinterpret_cast<const ShapeFileHeader*>(file.data());
+    }
+    
+public:
+    // Map a file and check its header; on failure `error` says why
+    bool open(const std::string& path, std::string& error) {
+        if (!file.open(path, error)) return false;
+        
+        if (file.size() < sizeof(ShapeFileHeader)) {
+            error = path + " is too short for a shape file";
+        } else if (std::memcmp(header().magic, "PLYB", 4) != 0) {
+            error = path + " is not a binary shape file";
+        } else if (header().version != ShapeFileHeader::VERSION || header().key_bytes != sizeof(ShapeKey)) {
+            error = path + " uses an unsupported encoding version";
+        } else if (file.size() < sizeof(ShapeFileHeader) + header().count * sizeof(ShapeKey)) {
+            error = path + " is truncated";
+        } else {
+            return true;
+        }
+        file.release();
+        return false;
+    }
+    
+    int getN() const { return static_cast<int>(header().n); }
+    std::string getType() const { return ShapeFileHeader::typeName(header().type); }
+    size_t size() const { return static_cast<size_t>(header().count); }
+    
+    const ShapeKey* begin() const {
+        return reinterpret_cast<const ShapeKey*>(file.data() + sizeof(ShapeFileHeader));
+    }
+    const ShapeKey* end() const { return begin() + size(); }
+    const ShapeKey& operator[](size_t i) const { return begin()[i]; }
+    
+    // Release the pages holding records [0, i) once they have been read
+    void dropBefore(size_t i) { file.dropBefore(sizeof(ShapeFileHeader) + i * sizeof(ShapeKey)); }
+};
+
+// Compressed shape stream - sorted keys in independently decodable blocks.
+// A block stores its first key raw (hi word, then lo word) and every later
+// key as the varint-coded difference from its predecessor. An index of
+// (offset, first key) per block follows the blocks, so any block can be
+// found by rank or by key and blocks can be decoded in parallel.
+struct CompressedShapeHeader {
+    char magic[4];                      // "PLYZ"
+    uint16_t version;
+    uint16_t reserved0;
+    uint32_t n;                         // Polyomino size
+    uint32_t type;                      // Same codes as ShapeFileHeader
+    uint32_t block_keys;                // Keys per block (the last may hold fewer)
+    uint32_t reserved1;
+    uint64_t count;                     // Number of keys
+    uint64_t block_count;
+    uint64_t index_offset;              // File offset of the block index (8-byte aligned)
+    
+    static constexpr uint16_t VERSION = 2;
+};
+
+static_assert(sizeof(CompressedShapeHeader) == 48, "compressed header must be 48 bytes");
+
+struct CompressedBlockEntry {
+    uint64_t offset;                    // File offset of the block
+    ShapeKey first;                     // First key of the block
+};
+
+static_assert(sizeof(CompressedBlockEntry) == 24, "block index entries must be 24 bytes");
+
+// 128-bit varints (7 bits per byte, low bits first) and key differences
+struct KeyDelta {
+    static ShapeKey subtract(const ShapeKey& a, const ShapeKey& b) {
+        ShapeKey d;
+        d.lo = a.lo - b.lo;
+        d.hi = a.hi - b.hi - (a.lo < b.lo ? 1 : 0);
+        return d;
+    }
+    
+    static ShapeKey add(const ShapeKey& a, const ShapeKey& b) {
+        ShapeKey s;
+        s.lo = a.lo + b.lo;
+        s.hi = a.hi + b.hi + (s.lo < a.lo ? 1 : 0);
+        return s;
+    }
+    
+    // Keys are packed from the top bit down, so small shapes leave a run of
+    // zero bits at the bottom that every delta in a block shares
+    static int trailingZeros(const ShapeKey& v) {
+        if (v.lo) return Polyomino::countTrailingZeros64(v.lo);
+        return v.hi ? 64 + Polyomino::countTrailingZeros64(v.hi) : 128;
+    }
+    
+    static ShapeKey shiftRight(const ShapeKey& v, int s) {
+        if (s == 0) return v;
+        if (s >= 128) return ShapeKey();
+        ShapeKey r;
+        if (s >= 64) {
+            r.lo = v.hi >> (s - 64);
+        } else {
+            r.lo = (v.lo >> s) | (v.hi << (64 - s));
+            r.hi = v.hi >> s;
+        }
+        return r;
+    }
+    
+    static ShapeKey shiftLeft(const ShapeKey& v, int s) {
+        if (s == 0) return v;
+        if (s >= 128) return ShapeKey();
+        ShapeKey r;
+        if (s >= 64) {
+            r.hi = v.lo << (s - 64);
+        } else {
+            r.hi = (v.hi << s) | (v.lo >> (64 - s));
+            r.lo = v.lo << s;
+        }
+        return r;
+    }
+    
+    static void put(std::vector<uint8_t>& out, ShapeKey v) {
+        while (v.hi != 0 || v.lo >= 0x80) {
+            out.push_back(static_cast<uint8_t>(v.lo | 0x80));
+            v.lo = (v.lo >> 7) | (v.hi << 57);
+            v.hi >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(v.lo));
+    }
+    
+    // Decode one varint; returns nullptr if it runs past `end`
+    static const uint8_t* get(const uint8_t* p, const uint8_t* end, ShapeKey& v) {
+        v = ShapeKey();
+        for (int shift = 0; p < end && shift < 128; shift += 7) {
+            const uint64_t bits = *p & 0x7F;
+            if (shift < 64) {
+                v.lo |= bits << shift;
+                if (shift > 57) v.hi |= bits >> (64 - shift);
+            } else {
+                v.hi |= bits << (shift - 64);
+            }
+            if (!(*p++ & 0x80)) return p;
+        }
+        return nullptr;
+    }
+};
+
+// Streaming writer for compressed shape streams; keys must arrive in
+// ascending order. The header and index are written on close().
+class CompressedShapeWriter {
+private:
+    FILE* file = nullptr;
+    CompressedShapeHeader header{};
+    std::vector<CompressedBlockEntry> index;
+    std::vector<ShapeKey> pending;      // Keys of the block being filled
+    std::vector<uint8_t> block;
+    uint64_t offset = 0;
+    bool ok = true;
+    
+    // Block layout: first key (16 bytes), shift byte, then one varint per
+    // following key holding (key - previous) >> shift
+    void flushBlock() {
+        if (pending.empty()) return;
+        int shift = 127;
+        for (size_t i = 1; i < pending.size(); ++i) {
+            shift = std::min(shift, KeyDelta::trailingZeros(KeyDelta::subtract(pending[i], pending[i - 1])));
+        }
+        
+        index.push_back({offset, pending[0]});
+        block.resize(sizeof(ShapeKey));
+        std::memcpy(block.data(), &pending[0], sizeof(ShapeKey));
+        block.push_back(static_cast<uint8_t>(shift));
+        for (size_t i = 1; i < pending.size(); ++i) {
+            KeyDelta::put(block, KeyDelta::shiftRight(KeyDelta::subtract(pending[i], pending[i - 1]), shift));
+        }
+        
+        ok = std::fwrite(block.data(), 1, block.size(), file) == block.size() && ok;
+        offset += block.size();
+        pending.clear();
+    }
+    
+public:
+    static constexpr uint32_t DEFAULT_BLOCK_KEYS = 4096;
+    
+    CompressedShapeWriter() = default;
+    CompressedShapeWriter(const CompressedShapeWriter&) = delete;
+    CompressedShapeWriter& operator=(const CompressedShapeWriter&) = delete;
+    
+    ~CompressedShapeWriter() { close(); }
+    
+    bool open(const std::string& path, int n, const std::string& type,
+              uint32_t block_keys = DEFAULT_BLOCK_KEYS) {
+        file = std::fopen(path.c_str(), "wb");
+        if (!file) return false;
+        
+        std::memcpy(header.magic, "PLYZ", 4);
+        header.version = CompressedShapeHeader::VERSION;
+        header.n = static_cast<uint32_t>(n);
+        header.type = ShapeFileHeader::typeCode(type);
+        header.block_keys = block_keys;
+        index.clear();
+        offset = sizeof(header);
+        ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+        return ok;
+    }
+    
+    void write(const ShapeKey& key) {
+        pending.push_back(key);
+        header.count++;
+        if (pending.size() == header.block_keys) flushBlock();
+    }
+    
+    bool close() {
+        if (!file) return true;
+        flushBlock();
+        
+        // Zero-pad the last block so the index entries are aligned in the mapping
+        const uint8_t padding[alignof(CompressedBlockEntry)] = {};
+        const size_t pad = (alignof(CompressedBlockEntry) - offset % alignof(CompressedBlockEntry)) %
+                           alignof(CompressedBlockEntry);
+        ok = ok && std::fwrite(padding, 1, pad, file) == pad;
+        offset += pad;
+        
+        header.block_count = index.size();
+        header.index_offset = offset;
+        ok = ok && std::fwrite(index.data(), sizeof(CompressedBlockEntry), index.size(), file) == index.size();
+        ok = ok && std::fseek(file, 0, SEEK_SET) == 0;
+        ok = ok && std::fwrite(&header, sizeof(header), 1, file) == 1;
+        ok = std::fclose(file) == 0 && ok;
+        file = nullptr;
+        return ok;
+    }
+};
+
+// Reader for compressed shape streams. The file is mapped and blocks are
+// decoded on demand: one block for a random lookup, all of them (spread
+// over a thread pool) for a full decode.
+class CompressedShapeFile {
+private:
+    MappedFile file;
+    
+    const CompressedShapeHeader& header() const {
+        return *reinterpret_cast<const CompressedShapeHeader*>(file.data());
+    }
+    
+    const CompressedBlockEntry* index() const {
+        return reinterpret_cast<const CompressedBlockEntry*>(file.data() + header().index_offset);
+    }
+    
+    // Block offsets must rise strictly and stay between the header and the index
+    bool blocksInOrder() const {
+        uint64_t previous = 0;
+        for (size_t b = 0; b < blockCount(); ++b) {
+            const uint64_t offset = index()[b].offset;
+            if (offset < sizeof(CompressedShapeHeader) || offset >= header().index_offset ||
+                (b > 0 && offset <= previous)) {
+                return false;
+            }
+            previous = offset;
+        }
+        return true;
+    }
+    
+public:
+    // Map a file and check its header and index; on failure `error` says why
+    bool open(const std::string& path, std::string& error) {
+        if (!file.open(path, error)) return false;
+        
+        const CompressedShapeHeader& h = header();
+        if (file.size() < sizeof(CompressedShapeHeader)) {
+            error = path + " is too short for a compressed shape file";
+        } else if (std::memcmp(h.magic, "PLYZ", 4) != 0) {
+            error = path + " is not a compressed shape file";
+        } else if (h.version != CompressedShapeHeader::VERSION || h.block_keys == 0) {
+            error = path + " uses an unsupported encoding version";
+        } else if (h.index_offset % alignof(CompressedBlockEntry) != 0) {
+            error = path + " has a misaligned block index";
+        } else if (h.index_offset < sizeof(CompressedShapeHeader) || h.index_offset > file.size() ||
+                   h.block_count > (file.size() - h.index_offset) / sizeof(CompressedBlockEntry) ||
+                   h.block_count != (h.count + h.block_keys - 1) / h.block_keys) {
+            error = path + " is truncated";
+        } else if (!blocksInOrder()) {
+            error = path + " has a corrupt block index";
+        } else {
+            return true;
+        }
+        file.release();
+        return false;
+    }
+    
+    int getN() const { return static_cast<int>(header().n); }
+    std::string getType() const { return ShapeFileHeader::typeName(header().type); }
+    size_t size() const { return static_cast<size_t>(header().count); }
+    size_t blockCount() const { return static_cast<size_t>(header().block_count); }
+    size_t blockKeys() const { return header().block_keys; }
+    size_t fileBytes() const { return file.size(); }
+    
+    // Number of keys in block b
+    size_t blockSize(size_t b) const {
+        return std::min<size_t>(blockKeys(), size() - b * blockKeys());
+    }
+    
+    // First key of block b, straight from the index
+    const ShapeKey& blockFirst(size_t b) const { return index()[b].first; }
+    
+    // Decode block b into out[0 .. blockSize(b)); false if it is corrupt,
+    // including a first key that disagrees with the index
+    bool decodeBlock(size_t b, ShapeKey* out) const {
+        const uint8_t* p = file.data() + index()[b].offset;
+        const uint8_t* end = b + 1 < blockCount() ? file.data() + index()[b + 1].offset
+                                                  : file.data() + header().index_offset;
+        if (p + sizeof(ShapeKey) + 1 > end) return false;
+        
+        std::memcpy(&out[0], p, sizeof(ShapeKey));
+        if (out[0] != index()[b].first) return false;
+        p += sizeof(ShapeKey);
+        const int shift = *p++;
+        const size_t n = blockSize(b);
+        for (size_t i = 1; i < n; ++i) {
+            ShapeKey delta;
+            p = KeyDelta::get(p, end, delta);
+            if (!p) return false;
+            out[i] = KeyDelta::add(out[i - 1], KeyDelta::shiftLeft(delta, shift));
+        }
+        return true;
+    }
+    
+    // Key with rank i (0-based, ascending); decodes one block
+    bool at(size_t i, ShapeKey& key) const {
+        if (i >= size()) return false;
+        std::vector<ShapeKey> keys(blockSize(i / blockKeys()));
+        if (!decodeBlock(i / blockKeys(), keys.data())) return false;
+        key = keys[i % blockKeys()];
+        return true;
+    }
+    
+    // Decode every block into `out`, one block per pool task
+    bool decodeAll(LevelStore& out, int threads = 1) const {
+        out.resize(size());
+        std::atomic<bool> ok{true};
+        WorkStealingPool pool(threads);
+        pool.run(blockCount(), 1, [&](int, size_t b, size_t) {
+            if (!decodeBlock(b, out.data() + b * blockKeys())) ok = false;
+        });
+        return ok;
+    }
+};
+
+// Minimal perfect hash over a fixed key set, in the style of BBHash: each
+// level hashes the keys still unplaced into a bit array twice their number,
+// keeps the bits hit by exactly one key and passes the colliding keys on to
+// the next level. A key's value is the number of kept bits before its own,
+// so n keys map onto 0 .. n-1 using about 3 bits per key. The few keys left
+// after the last level go to a sorted overflow list. Keys outside the set
+// map to an arbitrary value (or n), so callers must check the result.
+class MinimalPerfectHash {
+private:
+    static constexpr int MAX_LEVELS = 24;
+    static constexpr size_t MIN_LEVEL_BITS = 64;
+    
+    std::vector<uint64_t> bits;         // Kept bits of every level, back to back
+    std::vector<uint64_t> level_start;  // Bit offset of each level, plus the end
+    std::vector<uint64_t> word_rank;    // Kept bits before each word
+    std::vector<ShapeKey> overflow;     // Keys no level could place, sorted
+    uint64_t placed = 0;                // Keys placed by the levels
+    
+    static uint64_t levelHash(const ShapeKey& key, int level) {
+        uint64_t h = key.hash() ^ (0x9e3779b97f4a7c15ULL * static_cast<uint64_t>(level + 1));
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return h;
+    }
+    
+    static size_t levelBits(size_t keys) {
+        return std::max(MIN_LEVEL_BITS, (2 * keys + 63) / 64 * 64);
+    }
+    
+    void buildRanks() {
+        word_rank.assign(bits.size() + 1, 0);
+        for (size_t w = 0; w < bits.size(); ++w) {
+            word_rank[w + 1] = word_rank[w] + static_cast<uint64_t>(Polyomino::popCount64(bits[w]));
+        }
+        placed = word_rank.back();
+    }
+    
+public:
+    void build(const ShapeKey* keys, size_t n) {
+        bits.clear();
+        level_start.assign(1, 0);
+        overflow.clear();
+        
+        std::vector<ShapeKey> pending(keys, keys + n);
+        std::vector<uint64_t> seen, collided;
+        for (int level = 0; level < MAX_LEVELS && !pending.empty(); ++level) {
+            const size_t m = levelBits(pending.size());
+            seen.assign(m / 64, 0);
+            collided.assign(m / 64, 0);
+            for (const auto& key : pending) {
+                const uint64_t pos = levelHash(key, level) % m;
+                const uint64_t bit = 1ULL << (pos & 63);
+                if (seen[pos >> 6] & bit) collided[pos >> 6] |= bit;
+                seen[pos >> 6] |= bit;
+            }
+            
+            for (size_t w = 0; w < seen.size(); ++w) bits.push_back(seen[w] & ~collided[w]);
+            level_start.push_back(level_start.back() + m);
+            
+            size_t kept = 0;
+            for (const auto& key : pending) {
+                const uint64_t pos = levelHash(key, level) % m;
+                if ((collided[pos >> 6] >> (pos & 63)) & 1) pending[kept++] = key;
+            }
+            pending.resize(kept);
+        }
+        
+        overflow = pending;
+        std::sort(overflow.begin(), overflow.end());
+        buildRanks();
+    }
+    
+    size_t size() const { return static_cast<size_t>(placed + overflow.size()); }
+    int levels() const { return static_cast<int>(level_start.size()) - 1; }
+    size_t bytes() const {
+        return (bits.size() + level_start.size() + word_rank.size()) * sizeof(uint64_t) +
+               overflow.size() * sizeof(ShapeKey);
+    }
+    
+    // Value in 0 .. size()-1 for keys of the set; size() if the key fell
+    // through every level and is not in the overflow list
+    uint64_t lookup(const ShapeKey& key) const {
+        for (int level = 0; level < levels(); ++level) {
+            const uint64_t m = level_start[level + 1] - level_start[level];
+            const uint64_t pos = level_start[level] + levelHash(key, level) % m;
+            const uint64_t word = bits[pos >> 6];
+            if ((word >> (pos & 63)) & 1) {
+                const uint64_t below = word & ((1ULL << (pos & 63)) - 1);
+                return word_rank[pos >> 6] + static_cast<uint64_t>(Polyomino::popCount64(below));
+            }
+        }
+        auto it = std::lower_bound(overflow.begin(), overflow.end(), key);
+        if (it == overflow.end() || *it != key) return size();
+        return placed + static_cast<uint64_t>(it - overflow.begin());
+    }
+    
+    // Serialized form: level count, overflow count, level offsets, bit
+    // words, overflow keys (usually none, so empty arrays are skipped)
+    bool save(FILE* file) const {
+        const uint64_t counts[2] = {static_cast<uint64_t>(levels()), overflow.size()};
+        return std::fwrite(counts, sizeof(uint64_t), 2, file) == 2 &&
+               std::fwrite(level_start.data(), sizeof(uint64_t), level_start.size(), file) == level_start.size() &&
+               (bits.empty() || std::fwrite(bits.data(), sizeof(uint64_t), bits.size(), file) == bits.size()) &&
+               (overflow.empty() ||
+                std::fwrite(overflow.data(), sizeof(ShapeKey), overflow.size(), file) == overflow.size());
+    }
+    
+    // Read what save() wrote, advancing `p`; false if it runs past `end`
+    bool load(const uint8_t*& p, const uint8_t* end) {
+        auto take = [&](void* out, size_t n) {
+            if (static_cast<size_t>(end - p) < n) return false;
+            std::memcpy(out, p, n);
+            p += n;
+            return true;
+        };
+        
+        uint64_t counts[2];
+        if (!take(counts, sizeof(counts)) || counts[0] > MAX_LEVELS) return false;
+        level_start.resize(counts[0] + 1);
+        if (!take(level_start.data(), level_start.size() * sizeof(uint64_t))) return false;
+        for (size_t l = 0; l + 1 < level_start.size(); ++l) {
+            if (level_start[l + 1] <= level_start[l] || (level_start[l + 1] - level_start[l]) % 64 != 0) return false;
+        }
+        if (level_start[0] != 0 || counts[1] > static_cast<uint64_t>(end - p) / sizeof(ShapeKey)) return false;
+        bits.resize(level_start.back() / 64);
+        overflow.resize(counts[1]);
+        if ((!bits.empty() && !take(bits.data(), bits.size() * sizeof(uint64_t))) ||
+            (!overflow.empty() && !take(overflow.data(), overflow.size() * sizeof(ShapeKey)))) return false;
+        buildRanks();
+        return true;
+    }
+};
+
+// Rank/unrank over a sorted binary shape file. Unrank is the record at that
+// position in the mapped file; rank goes through a minimal perfect hash to a
+// slot, a table maps the slot to its position, and the record there is
+// compared with the key to reject shapes that are not in the file. The hash
+// and table are saved next to the shape file (FILE.idx) and rebuilt when
+// missing or made for a different file.
+class ShapeIndex {
+private:
+    struct IndexHeader {
+        char magic[4];                  // "PLYI"
+        uint16_t version;
+        uint16_t reserved;
+        uint64_t count;                 // Keys in the shape file
+        ShapeKey first, last;           // Its first and last keys
+        
+        static constexpr uint16_t VERSION = 1;
+    };
+    
+    MappedShapeFile file;
+    MinimalPerfectHash hash;
+    std::vector<uint32_t> position;     // Hash slot -> rank
+    std::string index_path;
+    bool built = false;
+    
+    IndexHeader expectedHeader() const {
+        IndexHeader h{};
+        std::memcpy(h.magic, "PLYI", 4);
+        h.version = IndexHeader::VERSION;
+        h.count = file.size();
+        if (file.size() > 0) {
+            h.first = file[0];
+            h.last = file[file.size() - 1];
+        }
+        return h;
+    }
+    
+    bool load() {
+        MappedFile saved;
+        std::string ignored;
+        if (!saved.open(index_path, ignored) || saved.size() < sizeof(IndexHeader)) return false;
+        
+        const IndexHeader expected = expectedHeader();
+        IndexHeader h;
+        std::memcpy(&h, saved.data(), sizeof(h));
+        if (std::memcmp(h.magic, expected.magic, 4) != 0 || h.version != expected.version ||
+            h.count != expected.count || h.first != expected.first || h.last != expected.last) {
+            return false;
+        }
+        
+        const uint8_t* p = saved.data() + sizeof(IndexHeader);
+        const uint8_t* end = saved.data() + saved.size();
+        if (!hash.load(p, end) || hash.size() != file.size()) return false;
+        if (static_cast<size_t>(end - p) != file.size() * sizeof(uint32_t)) return false;
+        position.resize(file.size());
+        std::memcpy(position.data(), p, position.size() * sizeof(uint32_t));
+        
+        // A rank past the file would send rank() out of bounds; rebuild instead
+        for (uint32_t rank : position) {
+            if (rank >= file.size()) return false;
+        }
+        return true;
+    }
+    
+    bool save() const {
+        FILE* out = std::fopen(index_path.c_str(), "wb");
+        if (!out) return false;
+        const IndexHeader h = expectedHeader();
+        bool ok = std::fwrite(&h, sizeof(h), 1, out) == 1 && hash.save(out) &&
+                  std::fwrite(position.data(), sizeof(uint32_t), position.size(), out) == position.size();
+        ok = std::fclose(out) == 0 && ok;
+        if (!ok) std::remove(index_path.c_str());
+        return ok;
+    }
+    
+public:
+    // Map the shape file and load or build its index; a build that cannot be
+    // saved still works for this run
+    bool open(const std::string& path, std::string& error) {
+        if (!file.open(path, error)) return false;
+        if (file.size() > std::numeric_limits<uint32_t>::max()) {
+            error = path + " has too many shapes to index";
+            return false;
+        }
+        
+        index_path = path + ".idx";
+        if (load()) return true;
+        
+        hash.build(file.begin(), file.size());
+        position.assign(file.size(), 0);
+        for (size_t i = 0; i < file.size(); ++i) {
+            position[hash.lookup(file[i])] = static_cast<uint32_t>(i);
+        }
+        built = true;
+        if (!save()) std::cerr << "Warning: Cannot save index to " << index_path << "\n";
+        return true;
+    }
+    
+    int getN() const { return file.getN(); }
+    std::string getType() const { return file.getType(); }
+    size_t size() const { return file.size(); }
+    const std::string& getIndexPath() const { return index_path; }
+    bool wasBuilt() const { return built; }
+    size_t bytes() const { return hash.bytes() + position.size() * sizeof(uint32_t); }
+    
+    // Shape with the given id (its position in the sorted file)
+    bool unrank(uint64_t id, ShapeKey& key) const {
+        if (id >= file.size()) return false;
+        key = file[id];
+        return true;
+    }
+    
+    // Id of a canonical key; false if the file does not hold it
+    bool rank(const ShapeKey& key, uint64_t& id) const {
+        const uint64_t slot = hash.lookup(key);
+        if (slot >= position.size() || file[position[slot]] != key) return false;
+        id = position[slot];
+        return true;
+    }
+};
+
+// External-memory dedup for one BFS level. When the in-memory set outgrows
+// the budget it is drained as a sorted run into a binary shape file; at the
+// end of the level all runs are merged with a heap into one sorted level
+// file, dropping keys that appear in more than one run.
+class SpillStore {
+private:
+    std::string directory;
+    std::string type;
+    int size = 0;                       // Cell count of the keys being spilled
+    std::vector<std::string> runs;
+    
+public:
+    SpillStore(const std::string& dir, const std::string& t) : directory(dir), type(t) {}
+    
+    ~SpillStore() { clear(); }
+    
+    std::string levelPath(int n) const {
+        return directory + "/polyominoes.level-" + std::to_string(n) + ".bin";
+    }
+    
+    size_t runCount() const { return runs.size(); }
+    
+    // Delete any runs left over
+    void clear() {
+        for (const auto& path : runs) std::remove(path.c_str());
+        runs.clear();
+    }
+    
+    // Empty the set into a new sorted run of n-cell keys
+    bool spill(ShardedShapeSet& set, int n, int threads, std::string& error) {
+        if (runs.empty()) size = n;
+        LevelStore sorted;
+        set.drainSorted(sorted, threads);
+        
+        std::string path = directory + "/polyominoes.run-" + std::to_string(n) + "-" +
+                           std::to_string(runs.size()) + ".bin";
+        ShapeFileWriter writer;
+        if (!writer.open(path, n, type)) {
+            error = "cannot create " + path;
+            return false;
+        }
+        for (const auto& key : sorted) writer.write(key);
+        runs.push_back(path);
+        if (!writer.close()) {
+            error = "cannot write " + path;
+            return false;
+        }
+        return true;
+    }
+    
+    // Merge every run into the level file for `size` and delete the runs
+    bool merge(const std::string& path, std::string& error) {
+        std::vector<std::unique_ptr<MappedShapeFile>> inputs;
+        for (const auto& run : runs) {
+            inputs.emplace_back(new MappedShapeFile());
+            if (!inputs.back()->open(run, error)) return false;
+        }
+        
+        ShapeFileWriter writer;
+        if (!writer.open(path, size, type)) {
+            error = "cannot create " + path;
+            return false;
+        }
+        
+        using Head = std::pair<ShapeKey, size_t>;
+        auto greater = [](const Head& a, const Head& b) { return b.first < a.first; };
+        std::vector<Head> heap;
+        std::vector<size_t> pos(inputs.size(), 0);
+        for (size_t r = 0; r < inputs.size(); ++r) {
+            if (inputs[r]->size() > 0) heap.emplace_back((*inputs[r])[0], r);
+        }
+        std::make_heap(heap.begin(), heap.end(), greater);
+        
+        ShapeKey last;
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), greater);
+            const ShapeKey key = heap.back().first;
+            const size_t r = heap.back().second;
+            heap.pop_back();
+            
+            if (key != last) writer.write(key);
+            last = key;
+            
+            if (++pos[r] % (size_t(1) << 16) == 0) inputs[r]->dropBefore(pos[r]);
+            if (pos[r] < inputs[r]->size()) {
+                heap.emplace_back((*inputs[r])[pos[r]], r);
+                std::push_heap(heap.begin(), heap.end(), greater);
+            }
+        }
+        
+        inputs.clear();
+        clear();
+        if (!writer.close()) {
+            error = "cannot write " + path;
+            return false;
+        }
+        return true;
+    }
+};
+
+// Enumeration checkpoint - the BFS state needed to pick up a run where it
+// stopped: the current level, how many of its parents have been expanded and
+// the next-level keys produced from them so far. Files are written under a
+// temporary name and renamed into place, so a crash mid-write leaves the
+// previous checkpoint intact.
+class LevelCheckpoint {
+private:
+    struct Header {
+        char magic[4];                  // "PLYC"
+        uint16_t version;
+        uint16_t key_bytes;
+        uint32_t n;                     // Target size of the run
+        uint32_t type;                  // Same codes as ShapeFileHeader
+        uint32_t size;                  // Cell count of the level keys
+        uint32_t reserved;
+        uint64_t parents_done;          // Level keys already expanded
+        uint64_t generated;             // Extensions generated so far
+        uint64_t level_count;
+        uint64_t next_count;
+    };
+    
+    static_assert(sizeof(Header) == 56, "checkpoint header must be 56 bytes");
+    
+    static constexpr uint16_t VERSION = 1;
+    
+public:
+    int size = 1;
+    uint64_t parents_done = 0;
+    uint64_t generated = 0;
+    LevelStore level;                   // Shapes of `size` cells, sorted
+    std::vector<ShapeKey> next;         // Partial next level, any order
+    
+    bool save(const std::string& path, int n, const std::string& type, std::string& error) const {
+        Header header{};
+        std::memcpy(header.magic, "PLYC", 4);
+        header.version = VERSION;
+        header.key_bytes = sizeof(ShapeKey);
+        header.n = static_cast<uint32_t>(n);
+        header.type = ShapeFileHeader::typeCode(type);
+        header.size = static_cast<uint32_t>(size);
+        header.parents_done = parents_done;
+        header.generated = generated;
+        header.level_count = level.size();
+        header.next_count = next.size();
+        
+        std::string temp = path + ".tmp";
+        FILE* file = std::fopen(temp.c_str(), "wb");
+        if (!file) {
+            error = "cannot create " + temp;
+            return false;
+        }
+        // An empty level has no buffer to hand to fwrite
+        bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+        ok = ok && (level.empty() ||
+                    std::fwrite(level.data(), sizeof(ShapeKey), level.size(), file) == level.size());
+        ok = ok && (next.empty() ||
+                    std::fwrite(next.data(), sizeof(ShapeKey), next.size(), file) == next.size());
+        ok = ok && std::fflush(file) == 0;
+#if defined(__unix__) || defined(__APPLE__)
+        ok = ok && fsync(fileno(file)) == 0;
+#endif
+        ok = std::fclose(file) == 0 && ok;
+        if (!ok || std::rename(temp.c_str(), path.c_str()) != 0) {
+            std::remove(temp.c_str());
+            error = "cannot write " + path;
+            return false;
+        }
+        return true;
+    }
+    
+    // Load a checkpoint and check it belongs to a run of this type that has
+    // not gone past size n; on failure `error` says why
+    bool load(const std::string& path, int n, const std::string& type, std::string& error) {
+        FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file) {
+            error = "cannot open " + path;
+            return false;
+        }
+        
+        Header header{};
+        bool ok = std::fread(&header, sizeof(header), 1, file) == 1;
+        if (!ok || std::memcmp(header.magic, "PLYC", 4) != 0 || header.version != VERSION ||
+            header.key_bytes != sizeof(ShapeKey)) {
+            std::fclose(file);
+            error = path + " is not a checkpoint file";
+            return false;
+        }
+        if (header.type != ShapeFileHeader::typeCode(type)) {
+            std::fclose(file);
+            error = path + " holds " + ShapeFileHeader::typeName(header.type) + " shapes, not " + type;
+            return false;
+        }
+        if (header.size < 1 || static_cast<int>(header.size) > n ||
+            header.parents_done > header.level_count) {
+            std::fclose(file);
+            error = path + " does not fit a run with N=" + std::to_string(n);
+            return false;
+        }
+        
+        // The counts must account for the file exactly before anything is allocated
+        const long file_bytes = std::fseek(file, 0, SEEK_END) == 0 ? std::ftell(file) : -1;
+        const uint64_t keys = file_bytes < static_cast<long>(sizeof(Header)) ? 0
+                            : (static_cast<uint64_t>(file_bytes) - sizeof(Header)) / sizeof(ShapeKey);
+        if (file_bytes < 0 || header.level_count > keys || header.next_count > keys - header.level_count ||
+            static_cast<uint64_t>(file_bytes) !=
+                sizeof(Header) + (header.level_count + header.next_count) * sizeof(ShapeKey) ||
+            std::fseek(file, sizeof(Header), SEEK_SET) != 0) {
+            std::fclose(file);
+            error = path + " is truncated or corrupt";
+            return false;
+        }
+        
+        level.resize(header.level_count);
+        next.resize(header.next_count);
+        ok = level.empty() || std::fread(level.data(), sizeof(ShapeKey), level.size(), file) == level.size();
+        ok = ok && (next.empty() ||
+                    std::fread(next.data(), sizeof(ShapeKey), next.size(), file) == next.size());
+        std::fclose(file);
+        if (!ok) {
+            error = path + " is truncated";
+            return false;
+        }
+        
+        size = static_cast<int>(header.size);
+        parents_done = header.parents_done;
+        generated = header.generated;
+        return true;
+    }
+};
+
+// Hardware performance counters for the calling thread - cycles,
+// instructions, last-level cache misses and branch misses via Linux
+// perf_event_open, counted in user space only. Where counters cannot be
+// opened (other platforms, no PMU, perf_event_paranoid) samples still carry
+// the wall time and the counter values stay zero.
+class PerfCounters {
+public:
+    enum Event { CYCLES, INSTRUCTIONS, LLC_MISSES, BRANCH_MISSES, EVENTS };
+    
+    struct Sample {
+        uint64_t value[EVENTS] = {};
+        uint64_t nanoseconds = 0;
+        
+        Sample operator-(const Sample& other) const {
+            Sample delta;
+            for (int e = 0; e < EVENTS; ++e) delta.value[e] = value[e] - other.value[e];
+            delta.nanoseconds = nanoseconds - other.nanoseconds;
+            return delta;
+        }
+        
+        Sample& operator+=(const Sample& other) {
+            for (int e = 0; e < EVENTS; ++e) value[e] += other.value[e];
+            nanoseconds += other.nanoseconds;
+            return *this;
+        }
+    };
+    
+    static const char* eventName(int e) {
+        static const char* const names[EVENTS] = {"cycles", "instructions", "llc_misses", "branch_misses"};
+        return names[e];
+    }
+    
+private:
+    int fds[EVENTS] = {-1, -1, -1, -1};
+    bool grouped = false;
+    bool attempted = false;
+    
+public:
+    PerfCounters() = default;
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+    
+    ~PerfCounters() { close(); }
+    
+    bool isOpen() const { return fds[0] >= 0; }
+    bool wasAttempted() const { return attempted; }
+    
+    // Start counting the calling thread. Without `inherit` the events form
+    // one group read with a single call; with it, threads started later add
+    // their counts when they exit. On failure `error` says why.
+    bool open(bool inherit, std::string& error) {
+        close();
+        attempted = true;
+#if defined(__linux__)
+        const uint64_t configs[EVENTS] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+        grouped = !inherit;
+        
+        for (int e = 0; e < EVENTS; ++e) {
+            struct perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[e];
+            attr.disabled = e == 0 || !grouped ? 1 : 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.inherit = inherit ? 1 : 0;
+            attr.read_format = grouped ? PERF_FORMAT_GROUP : 0;
+            
+            int leader = grouped && e > 0 ? fds[0] : -1;
+            long fd = syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+            if (fd < 0) {
+                error = std::string("perf_event_open: ") + std::strerror(errno);
+                close();
+                return false;
+            }
+            fds[e] = static_cast<int>(fd);
+        }
+        
+        for (int e = 0; e < (grouped ? 1 : EVENTS); ++e) {
+            ioctl(fds[e], PERF_EVENT_IOC_RESET, grouped ? PERF_IOC_FLAG_GROUP : 0);
+            ioctl(fds[e], PERF_EVENT_IOC_ENABLE, grouped ? PERF_IOC_FLAG_GROUP : 0);
+        }
+        return true;
+#else
+        (void)inherit;
+        error = "hardware counters are only supported on Linux";
+        return false;
+#endif
+    }
+    
+    void close() {
+#if defined(__linux__)
+        for (int e = EVENTS - 1; e >= 0; --e) {
+            if (fds[e] >= 0) ::close(fds[e]);
+            fds[e] = -1;
+        }
+#endif
+    }
+    
+    Sample read() const {
+        Sample sample;
+        sample.nanoseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#if defined(__linux__)
+        if (!isOpen()) return sample;
+        if (grouped) {
+            uint64_t group[1 + EVENTS];
+            if (::read(fds[0], group, sizeof(group)) == static_cast<ssize_t>(sizeof(group))) {
+                for (int e = 0; e < EVENTS; ++e) sample.value[e] = group[1 + e];
+            }
+        } else {
+            for (int e = 0; e < EVENTS; ++e) {
+                uint64_t value = 0;
+                if (::read(fds[e], &value, sizeof(value)) == static_cast<ssize_t>(sizeof(value))) {
+                    sample.value[e] = value;
+                }
+            }
+        }
+#endif
+        return sample;
+    }
+};
+
+// Per-level counter totals for each phase of a BFS run. Workers add their
+// thread's totals once per chunk; the result is printed as a table and
+// written as JSON.
+class PhaseProfile {
+public:
+    enum Phase { EXTENSION, CANONICALIZATION, DEDUP, OUTPUT, PHASES };
+    
+    static const char* phaseName(int p) {
+        static const char* const names[PHASES] = {"extension", "canonicalization", "dedup", "output"};
+        return names[p];
+    }
+    
+    using Level = std::vector<PerfCounters::Sample>;  // One sample per phase
+    
+private:
+    std::mutex lock;
+    std::vector<Level> levels;          // Indexed by the size being built
+    bool counters = true;               // False once any thread failed to open
+    std::string counter_error;
+    
+public:
+    explicit PhaseProfile(int n) : levels(n + 1, Level(PHASES)) {}
+    
+    void add(int size, int phase, const PerfCounters::Sample& delta) {
+        std::lock_guard<std::mutex> guard(lock);
+        levels[size][phase] += delta;
+    }
+    
+    void add(int size, const Level& totals) {
+        std::lock_guard<std::mutex> guard(lock);
+        for (int p = 0; p < PHASES; ++p) levels[size][p] += totals[p];
+    }
+    
+    // Record that counters could not be opened; only timings are reported
+    void markUnavailable(const std::string& error) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (counters) counter_error = error;
+        counters = false;
+    }
+    
+    bool hasCounters() const { return counters; }
+    
+    void print(std::ostream& out) const {
+        const std::ios::fmtflags flags = out.flags();
+        const std::streamsize precision = out.precision();
+        out << "\n=== Phase Counters ===\n";
+        if (!counters) out << "Hardware counters unavailable (" << counter_error << "); times only\n";
+        out << std::setw(4) << "N" << "  " << std::setw(16) << "Phase" << "  " << std::setw(10) << "Seconds";
+        if (counters) {
+            out << "  " << std::setw(16) << "Cycles" << "  " << std::setw(16) << "Instructions"
+                << "  " << std::setw(6) << "IPC" << "  " << std::setw(12) << "LLC misses"
+                << "  " << std::setw(12) << "Br. misses";
+        }
+        out << "\n";
+        
+        for (size_t n = 0; n < levels.size(); ++n) {
+            for (int p = 0; p < PHASES; ++p) {
+                const auto& s = levels[n][p];
+                if (s.nanoseconds == 0) continue;
+                out << std::setw(4) << n << "  " << std::setw(16) << phaseName(p) << "  "
+                    << std::setw(10) << std::fixed << std::setprecision(6) << s.nanoseconds / 1e9;
+                if (counters) {
+                    double ipc = s.value[PerfCounters::CYCLES]
+                        ? double(s.value[PerfCounters::INSTRUCTIONS]) / s.value[PerfCounters::CYCLES] : 0;
+                    out << "  " << std::setw(16) << s.value[PerfCounters::CYCLES]
+                        << "  " << std::setw(16) << s.value[PerfCounters::INSTRUCTIONS]
+                        << "  " << std::setw(6) << std::setprecision(2) << ipc
+                        << "  " << std::setw(12) << s.value[PerfCounters::LLC_MISSES]
+                        << "  " << std::setw(12) << s.value[PerfCounters::BRANCH_MISSES];
+                }
+                out << "\n";
+            }
+        }
+        out.flags(flags);
+        out.precision(precision);
+    }
+    
+    bool saveJson(const std::string& path, const Config& config) const {
+        std::ofstream file(path);
+        if (!file.is_open()) return false;
+        
+        file << "{\"n\":" << config.N << ",\"type\":\"" << config.type << "\""
+             << ",\"engine\":\"" << config.engine << "\",\"threads\":" << config.threads
+             << ",\"counters\":" << (counters ? "true" : "false") << ",\"levels\":[";
+        bool first_level = true;
+        for (size_t n = 0; n < levels.size(); ++n) {
+            bool any = false;
+            for (int p = 0; p < PHASES; ++p) any = any || levels[n][p].nanoseconds > 0;
+            if (!any) continue;
+            
+            file << (first_level ? "" : ",") << "\n  {\"size\":" << n << ",\"phases\":{";
+            first_level = false;
+            for (int p = 0; p < PHASES; ++p) {
+                const auto& s = levels[n][p];
+                file << (p ? "," : "") << "\"" << phaseName(p) << "\":{\"nanoseconds\":" << s.nanoseconds;
+                if (counters) {
+                    for (int e = 0; e < PerfCounters::EVENTS; ++e) {
+                        file << ",\"" << PerfCounters::eventName(e) << "\":" << s.value[e];
+                    }
+                }
+                file << "}";
+            }
+            file << "}}";
+        }
+        file << "\n]}\n";
+        return file.good();
+    }
+};
+
+// Histogram of the shapes of every size of a bfs run, keyed by (size,
+// perimeter, width, height, holes). Each worker counts into its own table,
+// so nothing is shared while the levels are expanded; the tables are merged
+// once for output. Free and one-sided shapes can be turned, so their box is
+// reported with width <= height.
+class ShapeStatistics {
+public:
+    struct Entry {
+        int size, perimeter, width, height, holes;
+        uint64_t count;
+    };
+    
+private:
+    // Padded so workers never write to the same cache line
+    struct alignas(64) Table {
+        std::unordered_map<uint64_t, uint64_t> counts;
+    };
+    
+    std::vector<Table> tables;
+    bool sort_box;
+    
+    // One byte per field, size in the top byte, so keys sort like entries
+    static uint64_t pack(int size, int perimeter, int width, int height, int holes) {
+        return static_cast<uint64_t>(size) << 32 | static_cast<uint64_t>(perimeter) << 24 |
+               static_cast<uint64_t>(width) << 16 | static_cast<uint64_t>(height) << 8 |
+               static_cast<uint64_t>(holes);
+    }
+    
+public:
+    ShapeStatistics(int threads, const std::string& type)
+        : tables(std::max(1, threads)), sort_box(type != "fixed") {}
+    
+    void add(int worker, const Polyomino& shape) {
+        int w = shape.getWidth(), h = shape.getHeight();
+        if (sort_box && w > h) std::swap(w, h);
+        tables[worker].counts[pack(static_cast<int>(shape.size()), shape.getPerimeter(), w, h,
+                                   shape.countHoles())]++;
+    }
+    
+    // All tables combined, sorted by size, perimeter, width, height, holes
+    std::vector<Entry> merged() const {
+        std::unordered_map<uint64_t, uint64_t> all;
+        for (const auto& table : tables) {
+            for (const auto& kv : table.counts) all[kv.first] += kv.second;
+        }
+        std::vector<std::pair<uint64_t, uint64_t>> sorted(all.begin(), all.end());
+        std::sort(sorted.begin(), sorted.end());
+        
+        std::vector<Entry> entries;
+        for (const auto& kv : sorted) {
+            entries.push_back({static_cast<int>(kv.first >> 32), static_cast<int>(kv.first >> 24 & 0xFF),
+                               static_cast<int>(kv.first >> 16 & 0xFF), static_cast<int>(kv.first >> 8 & 0xFF),
+                               static_cast<int>(kv.first & 0xFF), kv.second});
+        }
+        return entries;
+    }
+    
+    // One line per size: shape count, the range of each field and how many
+    // shapes have holes
+    void print(std::ostream& out) const {
+        struct Summary {
+            uint64_t shapes = 0, with_holes = 0;
+            int min_p = 1 << 30, max_p = 0, min_w = 1 << 30, max_w = 0, min_h = 1 << 30, max_h = 0, max_holes = 0;
+        };
+        std::vector<Summary> sizes;
+        for (const auto& e : merged()) {
+            if (static_cast<int>(sizes.size()) <= e.size) sizes.resize(e.size + 1);
+            Summary& s = sizes[e.size];
+            s.shapes += e.count;
+            if (e.holes > 0) s.with_holes += e.count;
+            s.min_p = std::min(s.min_p, e.perimeter);
+            s.max_p = std::max(s.max_p, e.perimeter);
+            s.min_w = std::min(s.min_w, e.width);
+            s.max_w = std::max(s.max_w, e.width);
+            s.min_h = std::min(s.min_h, e.height);
+            s.max_h = std::max(s.max_h, e.height);
+            s.max_holes = std::max(s.max_holes, e.holes);
+        }
+        
+        out << "=== Shape Statistics ===\n";
+        out << "size            shapes  perimeter  width  height     with holes  max holes\n";
+        for (size_t n = 0; n < sizes.size(); ++n) {
+            const Summary& s = sizes[n];
+            if (!s.shapes) continue;
+            out << std::setw(4) << n << "  " << std::setw(16) << s.shapes << "  "
+                << std::setw(4) << s.min_p << "-" << std::left << std::setw(4) << s.max_p << std::right
+                << " " << std::setw(2) << s.min_w << "-" << std::left << std::setw(2) << s.max_w << std::right
+                << "  " << std::setw(2) << s.min_h << "-" << std::left << std::setw(3) << s.max_h << std::right
+                << "  " << std::setw(13) << s.with_holes << "  " << std::setw(9) << s.max_holes << "\n";
+        }
+        out << "\n";
+    }
+    
+    bool saveCsv(const std::string& path) const {
+        std::ofstream file(path);
+        if (!file.is_open()) return false;
+        
+        file << "size,perimeter,width,height,holes,count\n";
+        for (const auto& e : merged()) {
+            file << e.size << "," << e.perimeter << "," << e.width << "," << e.height << ","
+                 << e.holes << "," << e.count << "\n";
+        }
+        return file.good();
+    }
+};
+
+// Shapes of every size of a free or one-sided bfs run, by symmetry class.
+// The classes give the other series exactly: a free shape with stabilizer H
+// stands for 8/|H| fixed shapes, and for one one-sided shape if H holds a
+// reflection or two otherwise; a one-sided shape stands for 4/|H| fixed ones.
+// Counts are kept per worker and added up for output.
+class SymmetryCensus {
+private:
+    // Padded so workers never write to the same cache line
+    struct alignas(64) Table {
+        std::vector<uint64_t> counts;   // [size * SYMMETRY_CLASSES + class]
+    };
+    
+    static constexpr int CLASSES = ShapeNormalizer::SYMMETRY_CLASSES;
+    
+    std::vector<Table> tables;
+    ShapeNormalizer normalizer;
+    int group_size;
+    int max_size;
+    
+public:
+    SymmetryCensus(int threads, const std::string& type, int n)
+        : tables(std::max(1, threads)), normalizer(type),
+          group_size(type == "free" ? 8 : 4), max_size(n) {
+        for (auto& table : tables) table.counts.assign((n + 1) * CLASSES, 0);
+    }
+    
+    void add(int worker, const Polyomino& shape) {
+        const CanonicalForm form = normalizer.canonicalize(shape);
+        const int c = ShapeNormalizer::symmetryClass(ShapeNormalizer::stabilizerMask(form));
+        tables[worker].counts[shape.size() * CLASSES + c]++;
+    }
+    
+    // Shapes of size n in class c, over all workers
+    uint64_t count(int n, int c) const {
+        uint64_t total = 0;
+        for (const auto& table : tables) total += table.counts[n * CLASSES + c];
+        return total;
+    }
+    
+    uint64_t total(int n) const {
+        uint64_t sum = 0;
+        for (int c = 0; c < CLASSES; ++c) sum += count(n, c);
+        return sum;
+    }
+    
+    uint64_t fixedCount(int n) const {
+        uint64_t sum = 0;
+        for (int c = 0; c < CLASSES; ++c) {
+            sum += count(n, c) * static_cast<uint64_t>(group_size / ShapeNormalizer::symmetryClassOrder(c));
+        }
+        return sum;
+    }
+    
+    // One-sided count of a free run (a one-sided run already is one)
+    uint64_t oneSidedCount(int n) const {
+        if (group_size == 4) return total(n);
+        uint64_t sum = 0;
+        for (int c = 0; c < CLASSES; ++c) {
+            sum += count(n, c) * (ShapeNormalizer::symmetryClassReflects(c) ? 1 : 2);
+        }
+        return sum;
+    }
+    
+    void print(std::ostream& out) const {
+        const bool free = group_size == 8;
+        out << "=== Symmetry Classes ===\n";
+        out << "size";
+        for (int c = 0; c < CLASSES; ++c) {
+            if (!free && ShapeNormalizer::symmetryClassReflects(c)) continue;
+            out << "  " << std::setw(12) << ShapeNormalizer::symmetryClassName(c);
+        }
+        if (free) out << "  " << std::setw(14) << "one-sided";
+        out << "  " << std::setw(14) << "fixed" << "\n";
+        
+        for (int n = 1; n <= max_size; ++n) {
+            out << std::setw(4) << n;
+            for (int c = 0; c < CLASSES; ++c) {
+                if (!free && ShapeNormalizer::symmetryClassReflects(c)) continue;
+                out << "  " << std::setw(12) << count(n, c);
+            }
+            if (free) out << "  " << std::setw(14) << oneSidedCount(n);
+            out << "  " << std::setw(14) << fixedCount(n) << "\n";
+        }
+        out << "\n";
+    }
+};
+
+// Bounded single-producer, single-consumer ring buffer. Each side owns one
+// index and only reads the other's, so the fast path takes no locks; the
+// capacity is a power of two. A side that finds the queue empty (consumer)
+// or full (producer) parks on a condition variable, and the other side only
+// signals when it moves the queue out of that state.
+template <typename T>
+class SpscQueue {
+private:
+    std::unique_ptr<T[]> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head{0};   // Next slot to pop (consumer)
+    alignas(64) std::atomic<size_t> tail{0};   // Next slot to push (producer)
+    std::atomic<bool> closed{false};
+    std::mutex lock;
+    std::condition_variable not_empty;         // The consumer waits here
+    std::condition_variable not_full;          // The producer waits here
+    
+    // Taking the lock orders the signal after a parked side's last check
+    void wake(std::condition_variable& parked) {
+        { std::lock_guard<std::mutex> guard(lock); }
+        parked.notify_one();
+    }
+    
+public:
+    explicit SpscQueue(size_t capacity) : slots(new T[capacity]), mask(capacity - 1) {}
+    
+    // The index stores and the reads of the other index that follow are
+    // sequentially consistent, so a transition is never missed by both sides
+    bool tryPush(const T& value) {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) > mask) return false;
+        slots[t & mask] = value;
+        tail.store(t + 1);
+        if (head.load() == t) wake(not_empty);
+        return true;
+    }
+    
+    bool tryPop(T& value) {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        value = slots[h & mask];
+        head.store(h + 1);
+        if (tail.load() - h > mask) wake(not_full);
+        return true;
+    }
+    
+    // Push, waiting while the queue is full
+    void push(const T& value) {
+        while (!tryPush(value)) {
+            std::unique_lock<std::mutex> guard(lock);
+            not_full.wait(guard, [&] { return tail.load() - head.load() <= mask; });
+        }
+    }
+    
+    // Pop, waiting while the queue is empty; false once it is closed and drained
+    bool pop(T& value) {
+        while (!tryPop(value)) {
+            std::unique_lock<std::mutex> guard(lock);
+            // Values pushed before closing are visible once it is seen
+            if (closed.load()) return tryPop(value);
+            not_empty.wait(guard, [&] { return head.load() != tail.load() || closed.load(); });
+        }
+        return true;
+    }
+    
+    // No more pushes; wakes the consumer to drain what is left
+    void close() {
+        closed.store(true);
+        wake(not_empty);
+    }
+};
+
+// Streaming output stage - the engine pushes the final level's keys in
+// order and a background thread formats them (text or binary shape file)
+// into large buffered writes, so output overlaps with the last merge and no
+// result vector is built.
+class AsyncShapeWriter {
+private:
+    Config config;
+    bool binary;                        // Binary shape file
+    bool compressed;                    // Compressed shape stream
+    SpscQueue<ShapeKey> queue;
+    std::thread worker;
+    bool ok = true;
+    std::string path;
+    
+    FILE* text_file = nullptr;
+    ShapeFileWriter binary_writer;
+    CompressedShapeWriter compressed_writer;
+    
+    static constexpr size_t BUFFER_BYTES = 1 << 20;
+    
+    void drain() {
+        std::string buffer;
+        buffer.reserve(BUFFER_BYTES + 4096);
+        uint64_t index = 0;
+        ShapeKey key;
+        
+        while (queue.pop(key)) {
+            if (binary) {
+                binary_writer.write(key);
+                continue;
+            }
+            if (compressed) {
+                compressed_writer.write(key);
+                continue;
+            }
+            
+            buffer += "Shape ";
+            buffer += std::to_string(++index);
+            buffer += ":\n";
+            key.toShape().appendText(buffer);
+            buffer += '\n';
+            if (buffer.size() >= BUFFER_BYTES) {
+                ok = std::fwrite(buffer.data(), 1, buffer.size(), text_file) == buffer.size() && ok;
+                buffer.clear();
+            }
+        }
+        
+        if (!buffer.empty()) {
+            ok = std::fwrite(buffer.data(), 1, buffer.size(), text_file) == buffer.size() && ok;
+        }
+    }
+    
+public:
+    explicit AsyncShapeWriter(const Config& cfg)
+        : config(cfg), binary(cfg.output == "binary"), compressed(cfg.output == "compressed"),
+          queue(size_t(1) << 16),
+          path(binary ? cfg.binary_file : compressed ? cfg.compressed_file : cfg.output_file) {}
+    
+    AsyncShapeWriter(const AsyncShapeWriter&) = delete;
+    AsyncShapeWriter& operator=(const AsyncShapeWriter&) = delete;
+    
+    ~AsyncShapeWriter() { finish(); }
+    
+    const std::string& getPath() const { return path; }
+    
+    // Open the output for `count` shapes and start the writer thread
+    bool start(uint64_t count) {
+        if (binary) {
+            if (!binary_writer.open(path, config.N, config.type)) return false;
+        } else if (compressed) {
+            if (!compressed_writer.open(path, config.N, config.type)) return false;
+        } else {
+            text_file = std::fopen(path.c_str(), "w");
+            if (!text_file) return false;
+            std::string header = "Polyomino Enumeration Results\n"
+                                 "============================\n"
+                                 "Size: " + std::to_string(config.N) + "\n"
+                                 "Type: " + config.type + "\n"
+                                 "Count: " + std::to_string(count) + "\n\n";
+            ok = std::fwrite(header.data(), 1, header.size(), text_file) == header.size();
+        }
+        worker = std::thread(&AsyncShapeWriter::drain, this);
+        return true;
+    }
+    
+    // Hand over the next key in output order; waits while the queue is full
+    void push(const ShapeKey& key) { queue.push(key); }
+    
+    // Flush everything and close the file; false on a write error
+    bool finish() {
+        if (worker.joinable()) {
+            queue.close();
+            worker.join();
+        }
+        if (text_file) {
+            ok = std::fclose(text_file) == 0 && ok;
+            text_file = nullptr;
+        }
+        if (binary) ok = binary_writer.close() && ok;
+        if (compressed) ok = compressed_writer.close() && ok;
+        return ok;
+    }
+};
+
+// Main shape generator using BFS-style growth
+class ShapeGenerator {
+private:
+    Config config;
+    ShapeNormalizer normalizer;
+    size_t generated_count = 0;         // Extensions produced by the last run
+    std::unique_ptr<LevelCheckpoint> resume_state;
+    PhaseProfile* profile = nullptr;    // Per-phase counters (bfs), if set
+    ShapeStatistics* statistics = nullptr; // Histogram of every level (bfs), if set
+    SymmetryCensus* census = nullptr;   // Symmetry classes of every level (bfs), if set
+    std::string error_message;          // Why the last enumeration failed
+    AsyncShapeWriter* stream = nullptr; // Receives the final level (bfs), if set
+    size_t result_count = 0;            // Shapes of size N found by the last run
+    size_t holed_count = 0;             // Of those, shapes with holes (--holes, --hole-free)
+    
+public:
+    explicit ShapeGenerator(const Config& cfg) 
+        : config(cfg), normalizer(cfg.type) {}
+    
+    // Extensions generated by the last enumeration
+    size_t getGeneratedCount() const { return generated_count; }
+    
+    // Append every one-cell extension of a polyomino to `out` and return how
+    // many were added. The frontier (empty neighbours) comes from one
+    // bitmask pass over the rows; each set bit is a child, so no candidate
+    // is tested against the cells and nothing is sorted or allocated when
+    // the output buffer is reused.
+    size_t getExtensions(const Polyomino& poly, std::vector<Polyomino>& out) const {
+        uint32_t frontier[Polyomino::MAX_CELLS + 2];
+        poly.getFrontier(frontier);
+        
+        size_t count = 0;
+        for (int fy = 0; fy < poly.getHeight() + 2; ++fy) {
+            for (uint32_t bits = frontier[fy]; bits; bits &= bits - 1) {
+                out.push_back(poly.withFrontierCell(Polyomino::countTrailingZeros(bits), fy));
+                count++;
+            }
+        }
+        return count;
+    }
+    
+    // Stream the final bfs level to `writer` instead of returning it;
+    // enumerate() then returns an empty vector
+    void setStream(AsyncShapeWriter* writer) { stream = writer; }
+    
+    // Number of shapes of size N found by the last enumeration
+    size_t getResultCount() const { return result_count; }
+    
+    // Reason the last enumeration stopped early (empty if it succeeded)
+    const std::string& getError() const { return error_message; }
+    
+    // Record per-phase hardware counters in `target` during enumerate()
+    void setProfile(PhaseProfile* target) { profile = target; }
+    
+    // Count every shape of every size into `target` during bfs runs
+    void setStatistics(ShapeStatistics* target) { statistics = target; }
+    
+    // Count every shape of every size by symmetry class during bfs runs
+    void setCensus(SymmetryCensus* target) { census = target; }
+    
+    // Whether shapes of size N are checked for holes
+    bool checkHoles() const { return config.holes || config.hole_free; }
+    
+    // Shapes of size N with holes in the last enumeration (--holes, --hole-free)
+    size_t getHoledCount() const { return holed_count; }
+    
+    // Whether finished shapes are being counted for statistics or census
+    bool observing() const { return statistics || census; }
+    
+    // Hand a finished shape of any size to the statistics and census
+    void observe(int worker, const Polyomino& shape) {
+        if (statistics) statistics->add(worker, shape);
+        if (census) census->add(worker, shape);
+    }
+    
+    // Load the BFS state to continue from; enumerate() picks it up
+    bool resumeFrom(const std::string& path, std::string& error) {
+        resume_state.reset(new LevelCheckpoint());
+        if (resume_state->load(path, config.N, config.type, error)) return true;
+        resume_state.reset();
+        return false;
+    }
+    
+    // Main enumeration function using iterative BFS. Each level is held as
+    // sorted compact keys; workers canonicalize extensions straight into a
+    // sharded hash set, which is drained in key order for the next level.
+    // With a checkpoint file set, parents are expanded in batches and the
+    // state is saved between batches once the interval has passed, and
+    // again after every completed level.
+    std::vector<Polyomino> enumerate() {
+        ProgressTracker tracker(config.show_progress, config.progress_interval, config.show_summary);
+        WorkStealingPool pool(config.threads);
+        ShardedShapeSet next_size_shapes;
+        error_message.clear();
+        holed_count = 0;
+        
+        // Start with single cell polyomino, or wherever the checkpoint left off
+        LevelCheckpoint state;
+        state.level.push_back(ShapeKey::fromShape(Polyomino(std::vector<Point>{{0, 0}})));
+        if (resume_state) {
+            state = std::move(*resume_state);
+            resume_state.reset();
+            for (const auto& key : state.next) next_size_shapes.insert(key);
+            state.next.clear();
+        }
+        
+        LevelStore& level = state.level;
+        size_t total_generated = state.generated;
+        
+        // Parents of the current level: the in-memory level, or the mapped
+        // level file once a level has been spilled and merged on disk
+        const ShapeKey* parents = level.data();
+        size_t parent_count = level.size();
+        MappedShapeFile level_file;
+        std::string level_path;
+        
+        const bool spilling = config.memory_limit > 0;
+        SpillStore spill(config.spill_dir, config.type);
+        
+        // One reusable extension buffer per worker
+        std::vector<std::vector<Polyomino>> buffers(config.threads);
+        
+        // The sorted drain runs on pool threads too; counters opened here
+        // with inheritance pick up their counts once they have exited
+        PerfCounters main_counters;
+        if (profile) {
+            std::string error;
+            if (!main_counters.open(true, error)) profile->markUnavailable(error);
+        }
+        
+        const bool checkpointing = !config.checkpoint_file.empty();
+        const size_t batch = spilling ? size_t(1) << 14
+                           : checkpointing ? size_t(1) << 16 : std::numeric_limits<size_t>::max();
+        auto last_checkpoint = std::chrono::steady_clock::now();
+        
+        auto checkpoint = [&](int size, size_t parents_done, size_t generated) {
+            state.size = size;
+            state.parents_done = parents_done;
+            state.generated = generated;
+            state.next = next_size_shapes.keys();
+            std::string error;
+            if (!state.save(config.checkpoint_file, config.N, config.type, error)) {
+                std::cerr << "\nWarning: checkpoint failed: " << error << "\n";
+            }
+            std::vector<ShapeKey>().swap(state.next);
+            last_checkpoint = std::chrono::steady_clock::now();
+        };
+        
+        const int start_size = state.size;
+        const size_t start_done = state.parents_done;
+        size_t streamed = 0;                // Final-level keys handed to the writer
+        
+        // Iteratively grow shapes
+        for (int size = start_size; size < config.N; ++size) {
+            std::atomic<size_t> generated{0};
+            size_t done = size == start_size ? start_done : 0;
+            
+            // Only the calling thread reports progress
+            auto poll = [&]() {
+                tracker.update(size + 1, next_size_shapes.size(), total_generated + generated);
+            };
+            
+            while (done < parent_count) {
+                size_t first = done;
+                size_t last = parent_count - first > batch ? first + batch : parent_count;
+                
+                pool.run(last - first, 256, [&](int worker, size_t begin, size_t end) {
+                    std::vector<Polyomino>& extensions = buffers[worker];
+                    if (profile) {
+                        generated += expandProfiled(worker, parents, first + begin, first + end, size + 1,
+                                                    extensions, next_size_shapes);
+                        return;
+                    }
+                    
+                    size_t produced = 0;
+                    for (size_t i = first + begin; i < first + end; ++i) {
+                        const Polyomino parent = parents[i].toShape();
+                        if (observing()) observe(worker, parent);
+                        extensions.clear();
+                        produced += getExtensions(parent, extensions);
+                        for (const auto& ext : extensions) {
+                            next_size_shapes.insert(ShapeKey::fromShape(normalizer.getCanonical(ext)));
+                        }
+                    }
+                    generated += produced;
+                }, poll);
+                done = last;
+                if (!level_path.empty()) level_file.dropBefore(done);
+                
+                // Over budget: move the set to disk as a sorted run
+                if (spilling && next_size_shapes.bytes() >= config.memory_limit) {
+                    if (!spill.spill(next_size_shapes, size + 1, config.threads, error_message)) {
+                        return {};
+                    }
+                }
+                
+                auto since = std::chrono::steady_clock::now() - last_checkpoint;
+                if (checkpointing && done < parent_count &&
+                    since >= std::chrono::seconds(config.checkpoint_interval)) {
+                    checkpoint(size, done, total_generated + generated);
+                }
+            }
+            
+            total_generated += generated;
+            PerfCounters::Sample before = main_counters.read();
+            if (spill.runCount() > 0) {
+                // Finish the level on disk and stream the next one from it
+                std::string previous = level_path;
+                level_path = spill.levelPath(size + 1);
+                if ((next_size_shapes.size() > 0 &&
+                     !spill.spill(next_size_shapes, size + 1, config.threads, error_message)) ||
+                    !spill.merge(level_path, error_message) ||
+                    !level_file.open(level_path, error_message)) {
+                    return {};
+                }
+                level.release();
+                parents = level_file.begin();
+                parent_count = level_file.size();
+                if (!previous.empty()) std::remove(previous.c_str());
+            } else if (stream && size + 1 == config.N && !config.hole_free) {
+                // The last level goes to the writer while it is being merged
+                streamed = next_size_shapes.size();
+                if (!stream->start(streamed)) {
+                    error_message = "cannot open output file " + stream->getPath();
+                    return {};
+                }
+                next_size_shapes.drainSorted([&](const ShapeKey& key) {
+                    if (observing() || checkHoles()) {
+                        const Polyomino shape = key.toShape();
+                        if (observing()) observe(0, shape);
+                        if (checkHoles() && shape.hasHoles()) holed_count++;
+                    }
+                    stream->push(key);
+                }, config.threads);
+                level.release();
+                parents = nullptr;
+                parent_count = 0;
+            } else {
+                next_size_shapes.drainSorted(level, config.threads);
+                parents = level.data();
+                parent_count = level.size();
+            }
+            if (profile) profile->add(size + 1, PhaseProfile::DEDUP, main_counters.read() - before);
+            if (checkpointing && !streamed) checkpoint(size + 1, 0, total_generated);
+        }
+        
+        // The final level is never expanded, so it gets a pass of its own
+        std::vector<uint8_t> holed;         // Final-level shapes with holes
+        if ((observing() || checkHoles()) && !streamed) {
+            if (checkHoles()) holed.assign(parent_count, 0);
+            pool.run(parent_count, 256, [&](int worker, size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    const Polyomino shape = parents[i].toShape();
+                    if (observing()) observe(worker, shape);
+                    if (!holed.empty()) holed[i] = shape.hasHoles();
+                }
+            });
+            for (uint8_t h : holed) holed_count += h;
+        }
+        auto keep = [&](size_t i) { return !config.hole_free || !holed[i]; };
+        
+        PerfCounters::Sample before = main_counters.read();
+        std::vector<Polyomino> result;
+        if (streamed) {
+            result_count = streamed;
+        } else if (stream) {
+            result_count = parent_count - (config.hole_free ? holed_count : 0);
+            if (!stream->start(result_count)) {
+                error_message = "cannot open output file " + stream->getPath();
+                return {};
+            }
+            for (size_t i = 0; i < parent_count; ++i) {
+                if (keep(i)) stream->push(parents[i]);
+            }
+        } else {
+            result_count = parent_count - (config.hole_free ? holed_count : 0);
+            // Under a memory limit a level too large to show is only counted
+            if (!spilling || result_count <= 50) {
+                result.reserve(result_count);
+                for (size_t i = 0; i < parent_count; ++i) {
+                    if (keep(i)) result.push_back(parents[i].toShape());
+                }
+            }
+        }
+        if (!level_path.empty()) std::remove(level_path.c_str());
+        if (profile) profile->add(config.N, PhaseProfile::OUTPUT, main_counters.read() - before);
+        
+        generated_count = total_generated;
+        tracker.finish(result_count);
+        return result;
+    }
+    
+    // Expand parents [begin, end) of a level in small groups, running the
+    // extension, canonicalization and dedup phases one after another so each
+    // gets its own counter readings. Counters belong to the worker thread.
+    size_t expandProfiled(int worker, const ShapeKey* parents, size_t begin, size_t end, int size,
+                          std::vector<Polyomino>& extensions, ShardedShapeSet& next) {
+        thread_local PerfCounters counters;
+        if (!counters.wasAttempted()) {
+            std::string error;
+            if (!counters.open(false, error)) profile->markUnavailable(error);
+        }
+        
+        PhaseProfile::Level totals(PhaseProfile::PHASES);
+        std::vector<ShapeKey> keys;
+        size_t produced = 0;
+        
+        for (size_t group = begin; group < end; group += 32) {
+            const size_t stop = std::min(end, group + 32);
+            PerfCounters::Sample start = counters.read();
+            
+            extensions.clear();
+            for (size_t i = group; i < stop; ++i) {
+                const Polyomino parent = parents[i].toShape();
+                if (observing()) observe(worker, parent);
+                produced += getExtensions(parent, extensions);
+            }
+            PerfCounters::Sample grown = counters.read();
+            
+            keys.clear();
+            for (const auto& ext : extensions) {
+                keys.push_back(ShapeKey::fromShape(normalizer.getCanonical(ext)));
+            }
+            PerfCounters::Sample canonical = counters.read();
+            
+            for (const auto& key : keys) next.insert(key);
+            PerfCounters::Sample inserted = counters.read();
+            
+            totals[PhaseProfile::EXTENSION] += grown - start;
+            totals[PhaseProfile::CANONICALIZATION] += canonical - grown;
+            totals[PhaseProfile::DEDUP] += inserted - canonical;
+        }
+        
+        profile->add(size, totals);
+        return produced;
+    }
+    
+    // Orderly enumeration by canonical augmentation: a child is kept only when
+    // its canonical parent is the shape that produced it, so every shape has
+    // exactly one producing parent and no cross-level dedup is needed. The
+    // search runs depth-first; only the pending children of the current path
+    // are held in memory, and each shape of size N goes to `visit` as soon as
+    // it is accepted. A visitor returning false stops the search; the return
+    // value says whether it ran to the end.
+    template <class Visitor>
+    bool visitOrderly(Visitor&& visit) {
+        ProgressTracker tracker(config.show_progress, config.progress_interval, config.show_summary);
+        
+        // pending[s] holds accepted shapes of size s still to be expanded
+        std::vector<std::vector<Polyomino>> pending(config.N + 1);
+        pending[1].push_back(Polyomino(std::vector<Point>{{0, 0}}));
+        
+        std::vector<Polyomino> extensions;
+        size_t total_generated = 0;
+        size_t visited = 0;
+        bool completed = true;
+        int size = 1;
+        
+        while (size > 0) {
+            if (pending[size].empty()) {
+                --size;
+                continue;
+            }
+            
+            Polyomino shape = pending[size].back();
+            pending[size].pop_back();
+            
+            if (size == config.N) {
+                visited++;
+                if (!visit(shape)) {
+                    completed = false;
+                    break;
+                }
+                continue;
+            }
+            
+            auto& children = pending[size + 1];
+            extensions.clear();
+            getExtensions(shape, extensions);
+            for (const auto& ext : extensions) {
+                total_generated++;
+                
+                Polyomino canonical = normalizer.getCanonical(ext);
+                if (normalizer.canonicalParent(canonical) == shape) {
+                    children.push_back(canonical);
+                }
+                
+                // Update progress
+                if (total_generated % 100 == 0) {
+                    tracker.update(size + 1, visited, total_generated);
+                }
+            }
+            
+            // Symmetric extensions of one parent can yield the same child
+            std::sort(children.begin(), children.end());
+            children.erase(std::unique(children.begin(), children.end()), children.end());
+            ++size;
+        }
+        
+        result_count = visited;
+        generated_count = total_generated;
+        tracker.finish(visited);
+        return completed;
+    }
+    
+    // Orderly enumeration collected into a vector, in the bfs engine's order
+    std::vector<Polyomino> enumerateOrderly() {
+        std::vector<Polyomino> result;
+        holed_count = 0;
+        visitOrderly([&](const Polyomino& shape) {
+            if (checkHoles() && shape.hasHoles()) {
+                holed_count++;
+                if (config.hole_free) return true;
+            }
+            result.push_back(shape);
+            return true;
+        });
+        std::sort(result.begin(), result.end());
+        result_count = result.size();
+        return result;
+    }
+};
+
+// Redelmeier counting engine - grows fixed polyominoes cell by cell over a
+// half-plane lattice using the untried-set method. Shapes are never stored:
+// memory is one mark grid plus an untried list per depth, and a single run
+// yields the fixed count of every size up to N.
+//
+// The search is a tree, so it splits into independent work units: the nodes
+// of size prefix_depth are numbered in search order and node j belongs to
+// unit j % unit_count, which counts its whole subtree. Unit 0 also counts the
+// sizes below the prefix depth. Summing every unit gives the full counts.
+class RedelmeierCounter {
+private:
+    Config config;
+    int width;                          // Lattice row stride
+    std::vector<uint8_t> seen;          // Cells already in or next to the polyomino
+    
+    // Lattice index of (x, y), with x in [-N-1, N+1] and y in [-1, N]
+    int index(int x, int y) const {
+        return (y + 1) * width + (x + config.N + 1);
+    }
+    
+public:
+    explicit RedelmeierCounter(const Config& cfg) 
+        : config(cfg), width(2 * cfg.N + 3) {}
+    
+    // Shape size at which the search splits into work units
+    static int prefixDepth(const Config& cfg) {
+        return cfg.prefix_depth > 0 ? cfg.prefix_depth : std::min(cfg.N, 10);
+    }
+    
+    // Count fixed polyominoes; counts[n] holds the total for size n (the
+    // share of this work unit when the search is split)
+    std::vector<uint64_t> count() {
+        const int N = config.N;
+        const int prefix = prefixDepth(config);
+        const bool below_prefix = config.unit_index == 0;
+        uint64_t prefix_nodes = 0;
+        ProgressTracker tracker(config.show_progress, config.progress_interval, config.show_summary);
+        std::vector<uint64_t> counts(N + 1, 0);
+        
+        // Cells below the origin row, or left of the origin on it, are
+        // blocked so every shape is counted once (at its lowest-leftmost cell)
+        seen.assign(static_cast<size_t>(width) * (N + 2), 0);
+        for (int x = -N - 1; x <= N + 1; ++x) {
+            seen[index(x, -1)] = 1;
+            if (x < 0) seen[index(x, 0)] = 1;
+        }
+        
+        const int neighbours[4] = {1, -1, width, -width};
+        
+        // untried[d] holds candidate cells for growing a shape of size d;
+        // marked records cells flagged in seen, unwound on backtrack
+        std::vector<std::vector<int>> untried(N, std::vector<int>(4 * N + 4));
+        std::vector<int> untried_count(N, 0);
+        std::vector<size_t> mark_base(N, 0);
+        std::vector<int> marked;
+        marked.reserve(4 * N + 4);
+        
+        const int origin = index(0, 0);
+        seen[origin] = 1;
+        untried[0][0] = origin;
+        untried_count[0] = 1;
+        
+        uint64_t total_generated = 0;
+        int depth = 0;
+        
+        while (true) {
+            if (untried_count[depth] == 0) {
+                if (depth == 0) break;
+                
+                // Backtrack: release the neighbours this level flagged
+                while (marked.size() > mark_base[depth]) {
+                    seen[marked.back()] = 0;
+                    marked.pop_back();
+                }
+                --depth;
+                continue;
+            }
+            
+            int cell = untried[depth][--untried_count[depth]];
+            
+            // Only this unit's share of the prefix nodes is searched; the
+            // other units walk the sizes below without counting them
+            if (depth + 1 == prefix &&
+                prefix_nodes++ % config.unit_count != static_cast<uint64_t>(config.unit_index)) {
+                continue;
+            }
+            
+            if (depth + 1 >= prefix || below_prefix) {
+                counts[depth + 1]++;
+                total_generated++;
+                
+                if ((total_generated & 0xFFFFF) == 0) {
+                    tracker.update(N, counts[N], total_generated);
+                }
+            }
+            
+            if (depth + 1 == N) continue;
+            
+            // Child inherits the remaining candidates plus new neighbours
+            int next = depth + 1;
+            std::copy(untried[depth].begin(), untried[depth].begin() + untried_count[depth],
+                      untried[next].begin());
+            untried_count[next] = untried_count[depth];
+            mark_base[next] = marked.size();
+            
+            for (int offset : neighbours) {
+                int nb = cell + offset;
+                if (!seen[nb]) {
+                    seen[nb] = 1;
+                    marked.push_back(nb);
+                    untried[next][untried_count[next]++] = nb;
+                }
+            }
+            
+            depth = next;
+        }
+        
+        tracker.finish(counts[N]);
+        return counts;
+    }
+};
+
+// Partial counts of one Redelmeier work unit, stored as a small text file so
+// units from any machine can be inspected and added up with --merge.
+struct WorkUnitFile {
+    int n = 0;
+    int prefix = 0;
+    int index = 0;
+    int total = 1;                      // Number of units in the split
+    std::vector<uint64_t> counts;       // counts[s] for s = 0..n
+    
+    static std::string defaultPath(int index, int total) {
+        return "polyominoes.unit-" + std::to_string(index) + "-of-" + std::to_string(total) + ".txt";
+    }
+    
+    bool save(const std::string& path, std::string& error) const {
+        std::ofstream file(path);
+        if (!file.is_open()) {
+            error = "cannot create " + path;
+            return false;
+        }
+        file << "polyomino-unit 1\n";
+        file << "engine redelmeier\n";
+        file << "type fixed\n";
+        file << "n " << n << "\n";
+        file << "prefix " << prefix << "\n";
+        file << "unit " << index << " " << total << "\n";
+        for (int s = 1; s <= n; ++s) {
+            file << "count " << s << " " << counts[s] << "\n";
+        }
+        file << "end\n";
+        if (!file.good()) {
+            error = "cannot write " + path;
+            return false;
+        }
+        return true;
+    }
+    
+    bool load(const std::string& path, std::string& error) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            error = "cannot open " + path;
+            return false;
+        }
+        
+        std::string line, word;
+        std::getline(file, line);
+        if (line != "polyomino-unit 1") {
+            error = path + " is not a work unit file";
+            return false;
+        }
+        
+        bool complete = false;
+        while (std::getline(file, line)) {
+            std::istringstream fields(line);
+            fields >> word;
+            if (word == "n") {
+                fields >> n;
+                counts.assign(std::max(n, 0) + 1, 0);
+            } else if (word == "prefix") {
+                fields >> prefix;
+            } else if (word == "unit") {
+                fields >> index >> total;
+            } else if (word == "count") {
+                int s = 0;
+                uint64_t value = 0;
+                fields >> s >> value;
+                if (s < 1 || s > n) fields.setstate(std::ios::failbit);
+                else counts[s] = value;
+            } else if (word == "end") {
+                complete = true;
+            }
+            if (fields.fail()) {
+                error = path + ": malformed line '" + line + "'";
+                return false;
+            }
+        }
+        
+        if (!complete || n < 1 || total < 1 || index < 0 || index >= total) {
+            error = path + " is incomplete";
+            return false;
+        }
+        return true;
+    }
+    
+    // Add up a complete set of unit files; every unit of the split must be
+    // present exactly once and all files must describe the same split
+    static bool merge(const std::vector<std::string>& paths, WorkUnitFile& merged, std::string& error) {
+        std::vector<std::string> seen_by;
+        for (const auto& path : paths) {
+            WorkUnitFile unit;
+            if (!unit.load(path, error)) return false;
+            
+            if (seen_by.empty()) {
+                merged = unit;
+                merged.index = 0;
+                std::fill(merged.counts.begin(), merged.counts.end(), 0);
+                seen_by.resize(unit.total);
+            } else if (unit.n != merged.n || unit.prefix != merged.prefix || unit.total != merged.total) {
+                error = path + " belongs to a different split";
+                return false;
+            }
+            
+            if (!seen_by[unit.index].empty()) {
+                error = "unit " + std::to_string(unit.index) + " appears in both " +
+                        seen_by[unit.index] + " and " + path;
+                return false;
+            }
+            seen_by[unit.index] = path;
+            for (int s = 1; s <= unit.n; ++s) merged.counts[s] += unit.counts[s];
+        }
+        
+        if (seen_by.empty()) {
+            error = "no unit files given";
+            return false;
+        }
+        
+        std::string missing;
+        for (size_t i = 0; i < seen_by.size(); ++i) {
+            if (seen_by[i].empty()) missing += (missing.empty() ? "" : ", ") + std::to_string(i);
+        }
+        if (!missing.empty()) {
+            error = "missing unit(s) " + missing + " of " + std::to_string(merged.total);
+            return false;
+        }
+        return true;
+    }
+};
+
+// Symmetric polyomino counter - counts fixed polyominoes that are mapped onto
+// a translate of themselves by a given symmetry. These are the Burnside terms
+// that turn fixed counts into free and one-sided counts. Shapes are grown as
+// unions of symmetry orbits with the untried-set method; for rotations, the
+// orbit union is only connected once the shape winds around the centre, which
+// is tracked as the subgroup of sheet shifts ("monodromy") closed so far.
+class SymmetryCounter {
+private:
+    // Integer affine map (x, y) -> (a*x + b*y + e, c*x + d*y + f) of order m
+    struct Symmetry {
+        int a, b, c, d, e, f, order;
+        
+        Point apply(const Point& p) const {
+            return Point(a * p.x + b * p.y + e, c * p.x + d * p.y + f);
+        }
+    };
+    
+    int N;
+    int radius;                         // Coordinates lie in [-radius, radius]
+    int width;                          // Lattice row stride
+    std::vector<uint8_t> seen;          // Orbits in, next to, or barred from the shape
+    std::vector<int8_t> sheet;          // Sheet shift of each included cell, -1 if absent
+    
+    int index(const Point& p) const {
+        return (p.y + radius) * width + (p.x + radius);
+    }
+    
+    Point point(int idx) const {
+        return Point(idx % width - radius, idx / width - radius);
+    }
+    
+    static int gcd(int a, int b) {
+        while (b) { int t = a % b; a = b; b = t; }
+        return a;
+    }
+    
+    // Cells of the orbit of p, in the order p, g(p), g^2(p), ...
+    int orbit(const Symmetry& g, int cell, int* out) const {
+        Point p = point(cell);
+        for (int k = 0; k < g.order; ++k) {
+            out[k] = index(p);
+            p = g.apply(p);
+        }
+        return g.order;
+    }
+    
+    void markOrbit(const Symmetry& g, int cell, uint8_t value) {
+        int cells[4];
+        orbit(g, cell, cells);
+        for (int k = 0; k < g.order; ++k) seen[cells[k]] = value;
+    }
+    
+    // Count connected g-invariant shapes containing the orbit of root, with
+    // the orbits of the barred cells excluded; adds into counts[size]
+    void countFrom(const Symmetry& g, const Point& root, const std::vector<Point>& barred,
+                   std::vector<uint64_t>& counts) {
+        const int m = g.order;
+        const int neighbours[4] = {1, -1, width, -width};
+        
+        seen.assign(static_cast<size_t>(width) * width, 0);
+        sheet.assign(seen.size(), -1);
+        
+        // Bar the lattice border so growth never leaves the grid
+        for (int idx = 0; idx < static_cast<int>(seen.size()); ++idx) {
+            Point p = point(idx);
+            if (std::abs(p.x) >= radius - 2 || std::abs(p.y) >= radius - 2) seen[idx] = 1;
+        }
+        for (const auto& p : barred) markOrbit(g, index(p), 1);
+        
+        // Per depth: untried orbit representatives, shape size, monodromy
+        // generator (1 once every sheet is joined) and the undo markers
+        std::vector<std::vector<int>> untried(N + 1);
+        std::vector<int> size(N + 1, 0), monodromy(N + 1, m), placed(N + 1, 0);
+        std::vector<size_t> mark_base(N + 1, 0);
+        std::vector<int> marked;
+        
+        int root_cell = index(root);
+        markOrbit(g, root_cell, 1);
+        untried[0].push_back(root_cell);
+        
+        int depth = 0;
+        while (true) {
+            // Undo the orbit placed by the previous pass at this depth
+            if (placed[depth]) {
+                int cells[4];
+                orbit(g, placed[depth] - 1, cells);
+                for (int k = 0; k < m; ++k) sheet[cells[k]] = -1;
+                placed[depth] = 0;
+                while (marked.size() > mark_base[depth + 1]) {
+                    markOrbit(g, marked.back(), 0);
+                    marked.pop_back();
+                }
+            }
+            
+            if (untried[depth].empty()) {
+                if (depth == 0) break;
+                --depth;
+                continue;
+            }
+            
+            int cell = untried[depth].back();
+            untried[depth].pop_back();
+            
+            int cells[4];
+            orbit(g, cell, cells);
+            int distinct = m;
+            for (int k = 1; k < m; ++k) {
+                if (cells[k] == cells[0]) { distinct = k; break; }
+            }
+            int new_size = size[depth] + distinct;
+            if (new_size > N) continue;
+            
+            // Place the orbit: pick the sheet of its first cell from an
+            // already placed neighbour, then every further adjacency (and any
+            // cell the symmetry fixes) closes a loop whose shift joins sheets
+            int base = 0;
+            if (depth > 0) {
+                for (int k = 0; k < m && !base; ++k) {
+                    for (int offset : neighbours) {
+                        int s = sheet[cells[k] + offset];
+                        if (s >= 0) { base = ((s - k) % m + m) % m + 1; break; }
+                    }
+                }
+                base -= 1;
+            }
+            
+            int generator = monodromy[depth];
+            for (int k = 0; k < m; ++k) {
+                int s = (base + k) % m;
+                if (sheet[cells[k]] >= 0) {
+                    generator = gcd(generator, (s - sheet[cells[k]] + m) % m);
+                } else {
+                    sheet[cells[k]] = static_cast<int8_t>(s);
+                }
+            }
+            for (int k = 0; k < distinct; ++k) {
+                for (int offset : neighbours) {
+                    int s = sheet[cells[k] + offset];
+                    if (s >= 0) generator = gcd(generator, (sheet[cells[k]] - s + m) % m);
+                }
+            }
+            int next = depth + 1;
+            placed[depth] = cell + 1;
+            mark_base[next] = marked.size();
+            
+            if (generator == 1) counts[new_size]++;
+            
+            if (new_size == N) continue;
+            
+            // Descend with the remaining candidates plus unseen neighbour orbits
+            untried[next] = untried[depth];
+            size[next] = new_size;
+            monodromy[next] = generator;
+            
+            for (int k = 0; k < distinct; ++k) {
+                for (int offset : neighbours) {
+                    int nb = cells[k] + offset;
+                    if (!seen[nb]) {
+                        markOrbit(g, nb, 1);
+                        marked.push_back(nb);
+                        untried[next].push_back(nb);
+                    }
+                }
+            }
+            
+            depth = next;
+        }
+    }
+    
+    // Rotations: a symmetric shape either covers the centre or winds around
+    // it, so it meets the ray through `step` from `start`; root at the first
+    // ray cell it contains and bar the ones before
+    void countRotation(const Symmetry& g, const Point& start, const Point& step,
+                       std::vector<uint64_t>& counts) {
+        std::vector<Point> barred;
+        Point root = start;
+        for (int t = 0; 2 * t <= N; ++t) {
+            countFrom(g, root, barred, counts);
+            barred.push_back(root);
+            root = root + step;
+        }
+    }
+    
+    // Reflections: a symmetric shape meets the axis, so fix its lowest axis
+    // orbit at the root and bar the axis below it to remove translations
+    void countReflection(const Symmetry& g, const Point& root, const Point& step,
+                         std::vector<uint64_t>& counts) {
+        std::vector<Point> barred;
+        Point p = root;
+        for (int t = 0; t <= N + 1; ++t) {
+            p = Point(p.x - step.x, p.y - step.y);
+            barred.push_back(p);
+        }
+        countFrom(g, root, barred, counts);
+    }
+    
+public:
+    // Fixed shapes invariant under each symmetry class, indexed by size
+    struct Terms {
+        std::vector<uint64_t> rot90;        // Quarter turn (same for 270)
+        std::vector<uint64_t> rot180;       // Half turn
+        std::vector<uint64_t> mirror_axis;  // Vertical axis (same for horizontal)
+        std::vector<uint64_t> mirror_diag;  // Main diagonal (same for anti-diagonal)
+    };
+    
+    explicit SymmetryCounter(int n) 
+        : N(n), radius(2 * n + 6), width(2 * radius + 1) {}
+    
+    Terms count() {
+        Terms terms;
+        terms.rot90.assign(N + 1, 0);
+        terms.rot180.assign(N + 1, 0);
+        terms.mirror_axis.assign(N + 1, 0);
+        terms.mirror_diag.assign(N + 1, 0);
+        
+        // Quarter turns about a cell centre and about a lattice vertex
+        countRotation({0, -1, 1, 0, 0, 0, 4}, Point(0, 0), Point(1, 0), terms.rot90);
+        countRotation({0, -1, 1, 0, 1, 0, 4}, Point(1, 1), Point(1, 1), terms.rot90);
+        
+        // Half turns about a cell centre, an edge midpoint and a vertex; the
+        // horizontal-edge case mirrors the vertical one and is counted twice
+        std::vector<uint64_t> edge(N + 1, 0);
+        countRotation({-1, 0, 0, -1, 0, 0, 2}, Point(0, 0), Point(1, 0), terms.rot180);
+        countRotation({-1, 0, 0, -1, 1, 0, 2}, Point(1, 0), Point(1, 0), edge);
+        countRotation({-1, 0, 0, -1, 1, 1, 2}, Point(1, 1), Point(1, 1), terms.rot180);
+        for (int n = 0; n <= N; ++n) terms.rot180[n] += 2 * edge[n];
+        
+        // Mirror axes through cell centres and along grid lines
+        countReflection({-1, 0, 0, 1, 0, 0, 2}, Point(0, 0), Point(0, 1), terms.mirror_axis);
+        countReflection({-1, 0, 0, 1, 1, 0, 2}, Point(0, 0), Point(0, 1), terms.mirror_axis);
+        
+        // Diagonal mirror; the axis always passes through cell centres
+        countReflection({0, 1, 1, 0, 0, 0, 2}, Point(0, 0), Point(1, 1), terms.mirror_diag);
+        
+        return terms;
+    }
+    
+    // Burnside's lemma over the rotation group (one-sided) or all of D4 (free)
+    static std::vector<uint64_t> reduce(const std::vector<uint64_t>& fixed, const Terms& terms,
+                                        const std::string& type) {
+        std::vector<uint64_t> result(fixed);
+        if (type == "fixed") return result;
+        
+        for (size_t n = 1; n < fixed.size(); ++n) {
+            uint64_t sum = fixed[n] + 2 * terms.rot90[n] + terms.rot180[n];
+            if (type == "one-sided") {
+                result[n] = sum / 4;
+            } else {
+                sum += 2 * terms.mirror_axis[n] + 2 * terms.mirror_diag[n];
+                result[n] = sum / 8;
+            }
+        }
+        return result;
+    }
+};
+
+// Burnside counting engine - free and one-sided counts without
+// canonicalizing anything. Fixed counts come from the Redelmeier engine and
+// the symmetric shapes from SymmetryCounter; the latter grow roughly like the
+// square root of the fixed counts, so the total cost stays close to that of
+// the fixed count alone.
+class BurnsideCounter {
+private:
+    Config config;
+    std::vector<uint64_t> fixed;
+    SymmetryCounter::Terms terms;
+    
+public:
+    explicit BurnsideCounter(const Config& cfg) : config(cfg) {}
+    
+    // Counts of config.type; counts[n] holds the total for size n
+    std::vector<uint64_t> count() {
+        ProgressTracker tracker(false, config.progress_interval, config.show_summary);
+        
+        Config fixed_config = config;
+        fixed_config.type = "fixed";
+        fixed_config.show_summary = false;
+        fixed = RedelmeierCounter(fixed_config).count();
+        
+        terms = SymmetryCounter(config.N).count();
+        auto counts = SymmetryCounter::reduce(fixed, terms, config.type);
+        
+        tracker.finish(counts[config.N]);
+        return counts;
+    }
+    
+    const std::vector<uint64_t>& getFixed() const { return fixed; }
+    const SymmetryCounter::Terms& getTerms() const { return terms; }
+};
+
+// Transfer-matrix counting engine (after Jensen) - counts fixed polyominoes by
+// bounding box. For each height W a cut line of W cells sweeps the box one
+// cell at a time; a frontier state records which cut cells are occupied, how
+// they are connected on the left, and whether the top and bottom rows have
+// been reached. Each state carries a generating polynomial in the cell count.
+// Only boxes with width >= height are swept, the rest follow by transposition,
+// so W never exceeds (N + 1) / 2.
+class TransferMatrixCounter {
+private:
+    Config config;
+    
+    static constexpr int MAX_HEIGHT = 17;
+    
+    // Packed frontier: 4-bit component label per cut cell, then the two flags
+    struct FrontierKey {
+        uint64_t lo = 0, hi = 0;
+        
+        bool operator==(const FrontierKey& other) const {
+            return lo == other.lo && hi == other.hi;
+        }
+    };
+    
+    struct FrontierKeyHash {
+        size_t operator()(const FrontierKey& k) const {
+            uint64_t h = k.lo * 0x9e3779b97f4a7c15ULL ^ (k.hi + 0x632be59bd9b4e019ULL);
+            return static_cast<size_t>(h ^ (h >> 29));
+        }
+    };
+    
+    struct Frontier {
+        uint8_t label[MAX_HEIGHT];
+        bool top, bottom;
+    };
+    
+    // States of one sweep position with their polynomials (stride N + 1)
+    struct FrontierTable {
+        std::unordered_map<FrontierKey, size_t, FrontierKeyHash> index;
+        std::vector<FrontierKey> keys;
+        std::vector<uint64_t> coeffs;
+        
+        uint64_t* slot(const FrontierKey& key, int stride) {
+            auto it = index.find(key);
+            if (it == index.end()) {
+                it = index.emplace(key, keys.size()).first;
+                keys.push_back(key);
+                coeffs.resize(coeffs.size() + stride, 0);
+            }
+            return coeffs.data() + it->second * stride;
+        }
+        
+        size_t size() const { return keys.size(); }
+    };
+    
+    int W = 1;
+    
+    FrontierKey encode(const Frontier& f) const {
+        FrontierKey key;
+        for (int i = 0; i < W; ++i) {
+            uint64_t v = f.label[i];
+            if (i < 16) key.lo |= v << (4 * i);
+            else key.hi |= v << (4 * (i - 16));
+        }
+        key.hi |= (static_cast<uint64_t>(f.top) << 62) | (static_cast<uint64_t>(f.bottom) << 63);
+        return key;
+    }
+    
+    Frontier decode(const FrontierKey& key) const {
+        Frontier f;
+        for (int i = 0; i < std::min(W, MAX_HEIGHT); ++i) {
+            f.label[i] = static_cast<uint8_t>(
+                (i < 16 ? key.lo >> (4 * i) : key.hi >> (4 * (i - 16))) & 0xF);
+        }
+        f.top = (key.hi >> 62) & 1;
+        f.bottom = (key.hi >> 63) & 1;
+        return f;
+    }
+    
+    // Relabel components in order of first appearance; returns their number
+    int normalizeLabels(Frontier& f) const {
+        uint8_t map[MAX_HEIGHT + 2] = {0};
+        int next = 0;
+        for (int i = 0; i < W; ++i) {
+            uint8_t l = f.label[i];
+            if (!l) continue;
+            if (!map[l]) map[l] = static_cast<uint8_t>(++next);
+            f.label[i] = map[l];
+        }
+        return next;
+    }
+    
+    // Lower bound on the cells still needed once `column` is swept to `row`:
+    // join the components, reach the untouched borders, and extend the box
+    // to width W (each future cell merges at most two components, and a path
+    // to row 0 or W-1 crosses every row in between)
+    int cellsNeeded(const Frontier& f, int components, int column) const {
+        if (components == 0) return 0;
+        
+        int min_row = W, max_row = -1;
+        for (int i = 0; i < W; ++i) {
+            if (f.label[i]) {
+                min_row = std::min(min_row, i);
+                max_row = std::max(max_row, i);
+            }
+        }
+        
+        int vertical = (f.top ? 0 : min_row + 1) + (f.bottom ? 0 : W - 1 - max_row);
+        int horizontal = std::max(0, W - 1 - column);
+        return std::max({components - 1, vertical, horizontal});
+    }
+    
+    // Sweep all boxes of height W, adding counts weighted by transposition
+    void sweep(std::vector<uint64_t>& counts, ProgressTracker& tracker, uint64_t& processed) {
+        const int N = config.N;
+        const int stride = N + 1;
+        
+        FrontierTable current;
+        Frontier start{};
+        start.top = start.bottom = false;
+        current.slot(encode(start), stride)[0] = 1;
+        
+        for (int column = 0; current.size() > 0 && column < N; ++column) {
+            for (int row = 0; row < W; ++row) {
+                FrontierTable next;
+                next.index.reserve(current.size() * 2);
+                
+                for (size_t s = 0; s < current.size(); ++s) {
+                    const uint64_t* poly = current.coeffs.data() + s * stride;
+                    int low = 0;
+                    while (low <= N && poly[low] == 0) ++low;
+                    if (low > N) continue;
+                    
+                    Frontier f = decode(current.keys[s]);
+                    
+                    auto emit = [&](Frontier g, int added) {
+                        int components = normalizeLabels(g);
+                        if (column == 0 && row == W - 1 && components == 0) return;
+                        int bound = cellsNeeded(g, components, column) + added;
+                        if (low + bound > N) return;
+                        
+                        uint64_t* target = next.slot(encode(g), stride);
+                        for (int k = low; k + bound <= N; ++k) {
+                            target[k + added] += poly[k];
+                        }
+                    };
+                    
+                    uint8_t left = f.label[row];
+                    uint8_t up = row > 0 ? f.label[row - 1] : 0;
+                    
+                    // Leave the cell empty unless that strands a component
+                    bool stranded = false;
+                    if (left) {
+                        stranded = true;
+                        for (int i = 0; i < W; ++i) {
+                            if (i != row && f.label[i] == left) { stranded = false; break; }
+                        }
+                    }
+                    if (!stranded) {
+                        Frontier g = f;
+                        g.label[row] = 0;
+                        emit(g, 0);
+                    }
+                    
+                    // Occupy the cell, joining the components above and left
+                    Frontier g = f;
+                    if (left && up && left != up) {
+                        for (int i = 0; i < W; ++i) {
+                            if (g.label[i] == left) g.label[i] = up;
+                        }
+                    } else if (!left) {
+                        g.label[row] = up ? up : static_cast<uint8_t>(MAX_HEIGHT + 1);
+                    }
+                    if (row == 0) g.top = true;
+                    if (row == W - 1) g.bottom = true;
+                    emit(g, 1);
+                }
+                
+                processed += current.size();
+                current = std::move(next);
+                tracker.update(N, counts[N], processed);
+            }
+            
+            // A single component touching both borders may stop here, giving
+            // a box of width column + 1; wider boxes also count transposed
+            int box_width = column + 1;
+            if (box_width < W) continue;
+            uint64_t weight = box_width == W ? 1 : 2;
+            
+            for (size_t s = 0; s < current.size(); ++s) {
+                Frontier f = decode(current.keys[s]);
+                if (!f.top || !f.bottom || normalizeLabels(f) != 1) continue;
+                
+                const uint64_t* poly = current.coeffs.data() + s * stride;
+                for (int k = 1; k <= N; ++k) counts[k] += weight * poly[k];
+            }
+        }
+    }
+    
+public:
+    explicit TransferMatrixCounter(const Config& cfg) : config(cfg) {}
+    
+    // Count polyominoes of the configured type; counts[n] holds the total for
+    // size n. Fixed totals are exact modulo 2^64, so intermediate wraparound
+    // is harmless; free and one-sided totals follow by Burnside's lemma.
+    std::vector<uint64_t> count() {
+        const int N = config.N;
+        ProgressTracker tracker(config.show_progress, config.progress_interval, config.show_summary);
+        std::vector<uint64_t> counts(N + 1, 0);
+        uint64_t processed = 0;
+        
+        for (W = 1; 2 * W - 1 <= N; ++W) {
+            sweep(counts, tracker, processed);
+        }
+        
+        if (config.type != "fixed") {
+            SymmetryCounter symmetric(N);
+            counts = SymmetryCounter::reduce(counts, symmetric.count(), config.type);
+        }
+        
+        tracker.finish(counts[N]);
+        return counts;
+    }
+};
+
+// Polycube - a 3D polyomino stored as packed voxel rows: row y of layer z
+// holds the x bits of its cells, rows[z * height + y]. Up to 12 cells the
+// box never has more than 42 rows and, with 12 bits for its dimensions,
+// always packs into a 128-bit ShapeKey, so polycube levels reuse the 2D
+// engine's key set, arena and thread pool.
+class Polycube {
+public:
+    static constexpr int MAX_CELLS = 12;
+    static constexpr int MAX_ROWS = 42;         // Largest height * depth of a 12-cube
+    static constexpr int MAX_SIDE = MAX_CELLS;
+    
+private:
+    uint8_t width = 0, height = 0, depth = 0;
+    uint8_t count = 0;
+    uint16_t rows[MAX_ROWS] = {};
+    
+    // Key layout, MSB first: 4 bits each of width - 1, height - 1 and
+    // depth - 1, then one bit per voxel of the box, x fastest
+    static void setKeyBit(ShapeKey& key, int pos) {
+        if (pos < 64) key.hi |= 1ULL << (63 - pos);
+        else key.lo |= 1ULL << (127 - pos);
+    }
+    
+    static bool getKeyBit(const ShapeKey& key, int pos) {
+        return pos < 64 ? (key.hi >> (63 - pos)) & 1 : (key.lo >> (127 - pos)) & 1;
+    }
+    
+public:
+    static constexpr int KEY_HEADER_BITS = 12;
+    
+    static Polycube single() {
+        Polycube cube;
+        cube.width = cube.height = cube.depth = 1;
+        cube.count = 1;
+        cube.rows[0] = 1;
+        return cube;
+    }
+    
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getDepth() const { return depth; }
+    size_t size() const { return count; }
+    uint16_t getRow(int y, int z) const { return rows[z * height + y]; }
+    
+    // Key of an arbitrary image: dimensions plus the voxel at linear index
+    // x + w * (y + h * z) for each cell
+    static ShapeKey makeKey(int w, int h, int d, const int* index, int cells) {
+        ShapeKey key;
+        key.hi = static_cast<uint64_t>((w - 1) << 8 | (h - 1) << 4 | (d - 1)) << 52;
+        for (int i = 0; i < cells; ++i) setKeyBit(key, KEY_HEADER_BITS + index[i]);
+        return key;
+    }
+    
+    ShapeKey toKey() const {
+        int index[MAX_CELLS];
+        int cells = 0;
+        for (int z = 0; z < depth; ++z) {
+            for (int y = 0; y < height; ++y) {
+                for (uint32_t bits = getRow(y, z); bits; bits &= bits - 1) {
+                    index[cells++] = Polyomino::countTrailingZeros(bits) + width * (y + height * z);
+                }
+            }
+        }
+        return makeKey(width, height, depth, index, cells);
+    }
+    
+    static Polycube fromKey(const ShapeKey& key) {
+        Polycube cube;
+        cube.width = static_cast<uint8_t>((key.hi >> 60 & 0xF) + 1);
+        cube.height = static_cast<uint8_t>((key.hi >> 56 & 0xF) + 1);
+        cube.depth = static_cast<uint8_t>((key.hi >> 52 & 0xF) + 1);
+        const int volume = cube.width * cube.height * cube.depth;
+        for (int i = 0; i < volume; ++i) {
+            if (!getKeyBit(key, KEY_HEADER_BITS + i)) continue;
+            cube.rows[i / cube.width] |= static_cast<uint16_t>(1u << (i % cube.width));
+            cube.count++;
+        }
+        return cube;
+    }
+    
+    // Empty cells face-adjacent to the cube, in a frame with a one-cell
+    // margin on every side: bit x + 1 of frontier[(z + 1) * (height + 2) + y + 1]
+    // is cell (x, y, z). One shift-and-mask step per frame row.
+    void getFrontier(uint32_t* frontier) const {
+        const int fh = height + 2, fd = depth + 2;
+        auto framed = [&](int fy, int fz) -> uint32_t {
+            if (fy < 1 || fy > height || fz < 1 || fz > depth) return 0;
+            return static_cast<uint32_t>(getRow(fy - 1, fz - 1)) << 1;
+        };
+        for (int fz = 0; fz < fd; ++fz) {
+            for (int fy = 0; fy < fh; ++fy) {
+                const uint32_t here = framed(fy, fz);
+                frontier[fz * fh + fy] = (here << 1 | here >> 1 | framed(fy - 1, fz) | framed(fy + 1, fz) |
+                                          framed(fy, fz - 1) | framed(fy, fz + 1)) & ~here;
+            }
+        }
+    }
+    
+    // Copy with frame cell (fx, fy, fz) added; a 0 coordinate grows the box
+    // towards negative values, which shifts the cube by one along that axis
+    Polycube withFrontierCell(int fx, int fy, int fz) const {
+        Polycube grown;
+        const int sx = fx == 0 ? 1 : 0;
+        const int sy = fy == 0 ? 1 : 0;
+        const int sz = fz == 0 ? 1 : 0;
+        grown.width = static_cast<uint8_t>(std::max<int>(width, fx) + sx);
+        grown.height = static_cast<uint8_t>(std::max<int>(height, fy) + sy);
+        grown.depth = static_cast<uint8_t>(std::max<int>(depth, fz) + sz);
+        grown.count = static_cast<uint8_t>(count + 1);
+        for (int z = 0; z < depth; ++z) {
+            for (int y = 0; y < height; ++y) {
+                grown.rows[(z + sz) * grown.height + y + sy] = static_cast<uint16_t>(getRow(y, z) << sx);
+            }
+        }
+        grown.rows[(fz - 1 + sz) * grown.height + fy - 1 + sy] |= static_cast<uint16_t>(1u << (fx - 1 + sx));
+        return grown;
+    }
+    
+    // Layers side by side, z increasing to the right
+    std::string toString() const {
+        std::string result;
+        for (int y = 0; y < height; ++y) {
+            for (int z = 0; z < depth; ++z) {
+                if (z > 0) result += "  ";
+                for (int x = 0; x < width; ++x) result += ((getRow(y, z) >> x) & 1u) ? '#' : '.';
+            }
+            result += '\n';
+        }
+        return result;
+    }
+};
+
+// Polycube canonicalizer. The 48 symmetries of the cube are the signed
+// permutations of the axes; the 24 with determinant +1 are the rotations.
+// Every image's key is built straight from the cell coordinates and the
+// smallest key wins, so "one-sided" means rotations only and "free" adds
+// the mirror images.
+class PolycubeNormalizer {
+private:
+    struct Element {
+        int axis[3];                    // Source axis of each image axis
+        bool flip[3];                   // Whether that axis is reversed
+    };
+    
+    std::vector<Element> group;
+    
+public:
+    explicit PolycubeNormalizer(const std::string& type) {
+        static const int permutations[6][3] = {
+            {0, 1, 2}, {1, 2, 0}, {2, 0, 1},    // Even
+            {0, 2, 1}, {2, 1, 0}, {1, 0, 2}};   // Odd
+        for (int p = 0; p < 6; ++p) {
+            for (int signs = 0; signs < 8; ++signs) {
+                const int flips = (signs & 1) + (signs >> 1 & 1) + (signs >> 2 & 1);
+                const bool rotation = ((p >= 3) + flips) % 2 == 0;
+                if (type == "fixed" && (p != 0 || signs != 0)) continue;
+                if (type == "one-sided" && !rotation) continue;
+                Element g;
+                for (int i = 0; i < 3; ++i) {
+                    g.axis[i] = permutations[p][i];
+                    g.flip[i] = (signs >> i) & 1;
+                }
+                group.push_back(g);
+            }
+        }
+    }
+    
+    size_t groupSize() const { return group.size(); }
+    
+    ShapeKey canonicalKey(const Polycube& cube) const {
+        int coords[Polycube::MAX_CELLS][3];
+        int cells = 0;
+        for (int z = 0; z < cube.getDepth(); ++z) {
+            for (int y = 0; y < cube.getHeight(); ++y) {
+                for (uint32_t bits = cube.getRow(y, z); bits; bits &= bits - 1) {
+                    coords[cells][0] = Polyomino::countTrailingZeros(bits);
+                    coords[cells][1] = y;
+                    coords[cells][2] = z;
+                    cells++;
+                }
+            }
+        }
+        
+        const int dims[3] = {cube.getWidth(), cube.getHeight(), cube.getDepth()};
+        ShapeKey best;
+        bool first = true;
+        int index[Polycube::MAX_CELLS];
+        for (const auto& g : group) {
+            const int w = dims[g.axis[0]], h = dims[g.axis[1]], d = dims[g.axis[2]];
+            for (int i = 0; i < cells; ++i) {
+                int c[3];
+                for (int a = 0; a < 3; ++a) {
+                    const int v = coords[i][g.axis[a]];
+                    c[a] = g.flip[a] ? dims[g.axis[a]] - 1 - v : v;
+                }
+                index[i] = c[0] + w * (c[1] + h * c[2]);
+            }
+            const ShapeKey key = Polycube::makeKey(w, h, d, index, cells);
+            if (first || key < best) best = key;
+            first = false;
+        }
+        return best;
+    }
+};
+
+// Polycube enumeration - the bfs engine on the cubic lattice: each level is
+// expanded on the work-stealing pool through the 6-neighbour frontier, the
+// children are canonicalized into keys and deduplicated in the sharded set,
+// and the set is drained sorted into the next level's arena.
+class PolycubeGenerator {
+private:
+    Config config;
+    PolycubeNormalizer normalizer;
+    size_t generated_count = 0;
+    
+public:
+    explicit PolycubeGenerator(const Config& cfg) : config(cfg), normalizer(cfg.type) {}
+    
+    size_t getGeneratedCount() const { return generated_count; }
+    
+    size_t getExtensions(const Polycube& cube, std::vector<Polycube>& out) const {
+        uint32_t frontier[(Polycube::MAX_SIDE + 2) * (Polycube::MAX_SIDE + 2)];
+        cube.getFrontier(frontier);
+        
+        const int fh = cube.getHeight() + 2, fd = cube.getDepth() + 2;
+        size_t produced = 0;
+        for (int fz = 0; fz < fd; ++fz) {
+            for (int fy = 0; fy < fh; ++fy) {
+                for (uint32_t bits = frontier[fz * fh + fy]; bits; bits &= bits - 1) {
+                    out.push_back(cube.withFrontierCell(Polyomino::countTrailingZeros(bits), fy, fz));
+                    produced++;
+                }
+            }
+        }
+        return produced;
+    }
+    
+    // Canonical keys of every polycube of size N, in ascending order
+    LevelStore enumerate() {
+        ProgressTracker tracker(config.show_progress, config.progress_interval, config.show_summary);
+        WorkStealingPool pool(config.threads);
+        ShardedShapeSet next;
+        std::vector<std::vector<Polycube>> buffers(config.threads);
+        
+        LevelStore level;
+        level.push_back(normalizer.canonicalKey(Polycube::single()));
+        size_t total_generated = 0;
+        
+        for (int size = 1; size < config.N; ++size) {
+            std::atomic<size_t> generated{0};
+            auto poll = [&]() { tracker.update(size + 1, next.size(), total_generated + generated); };
+            
+            pool.run(level.size(), 256, [&](int worker, size_t begin, size_t end) {
+                std::vector<Polycube>& extensions = buffers[worker];
+                size_t produced = 0;
+                for (size_t i = begin; i < end; ++i) {
+                    extensions.clear();
+                    produced += getExtensions(Polycube::fromKey(level[i]), extensions);
+                    for (const auto& ext : extensions) next.insert(normalizer.canonicalKey(ext));
+                }
+                generated += produced;
+            }, poll);
+            
+            total_generated += generated;
+            next.drainSorted(level, config.threads);
+        }
+        
+        generated_count = total_generated;
+        tracker.finish(level.size(), "polycubes");
+        return level;
+    }
+};
+
+// Visit every polyomino of `n` cells of the given type without collecting
+// them. Runs the orderly engine depth-first, so memory stays at the pending
+// children of one search path however many shapes there are. The visitor is
+// called with each canonical shape (a reference valid for the duration of
+// the call, in no particular order); it may return void, or a bool where
+// false stops the enumeration. Returns false if the visitor stopped it.
+// Throws std::invalid_argument if n is outside 1 .. Polyomino::MAX_CELLS or
+// the type is not "free", "one-sided" or "fixed".
+template <class Visitor>
+inline bool enumerate(int n, const std::string& type, Visitor&& visitor) {
+    if (n < 1 || n > Polyomino::MAX_CELLS) {
+        throw std::invalid_argument("enumerate: n must be between 1 and " +
+                                    std::to_string(Polyomino::MAX_CELLS));
+    }
+    if (type != "free" && type != "one-sided" && type != "fixed") {
+        throw std::invalid_argument("enumerate: type must be 'free', 'one-sided' or 'fixed'");
+    }
+    
+    Config config;
+    config.N = n;
+    config.type = type;
+    config.engine = "orderly";
+    config.show_progress = false;
+    config.show_summary = false;
+    
+    ShapeGenerator generator(config);
+    return generator.visitOrderly([&](const Polyomino& shape) {
+        if constexpr (std::is_void<decltype(visitor(shape))>::value) {
+            visitor(shape);
+            return true;
+        } else {
+            return static_cast<bool>(visitor(shape));
+        }
+    });
+}
+
+} // namespace polyomino
+
+#endif // POLYOMINO_HPP